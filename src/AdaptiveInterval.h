@@ -0,0 +1,28 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+
+namespace rpc {
+    // Polling interval that halves while the polled data keeps changing and doubles while it does
+    // not, between fixed bounds. Units are the caller's: ticks, seconds or milliseconds.
+    class AdaptiveInterval
+    {
+    public:
+        AdaptiveInterval(int64_t minimum, int64_t maximum, int64_t initial)
+            : minimum_(minimum), maximum_(maximum), interval_(std::clamp(initial, minimum, maximum)) {}
+
+        int64_t update(bool changed)
+        {
+            interval_ = changed ? std::max(minimum_, interval_ / 2) : std::min(maximum_, interval_ * 2);
+            return interval_;
+        }
+
+        void reset() { interval_ = minimum_; }
+        int64_t get() const { return interval_; }
+
+    private:
+        int64_t minimum_;
+        int64_t maximum_;
+        int64_t interval_;
+    };
+} // namespace rpc
@@ -0,0 +1,123 @@
+#include "BadgeEngine.h"
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <sstream>
+
+using namespace rpc;
+
+const char* const BadgeEngine::DEFAULT_RULES =
+    "# id counter threshold title\n"
+    "tracks-100 tracks 100 100 tracks in a session\n"
+    "online-4h online-minutes 240 4 hours online\n"
+    "handoffs-20 handoffs-hour 20 20 handoffs in an hour\n"
+    "first-sweatbox sweatbox 1 First sweatbox\n"
+    "first-fire on-fire 1 First time on fire\n";
+
+const char* BadgeEngine::counterName(Counter counter)
+{
+    switch (counter) {
+    case Counter::SESSION_TRACKS: return "tracks";
+    case Counter::ONLINE_MINUTES: return "online-minutes";
+    case Counter::HANDOFFS_PER_HOUR: return "handoffs-hour";
+    case Counter::SWEATBOX_CONNECTIONS: return "sweatbox";
+    case Counter::ON_FIRE: return "on-fire";
+    default: return "unknown";
+    }
+}
+
+bool BadgeEngine::compile(std::string_view rules, std::string& error)
+{
+    std::vector<Badge> badges;
+    size_t lineNumber = 0;
+    error.clear();
+    while (!rules.empty()) {
+        size_t end = rules.find('\n');
+        std::string_view line = rules.substr(0, end);
+        rules = end == std::string_view::npos ? std::string_view() : rules.substr(end + 1);
+        ++lineNumber;
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+
+        // Splits off the next space separated word
+        auto word = [&line]() {
+            size_t start = line.find_first_not_of(" \t");
+            if (start == std::string_view::npos) {
+                line = {};
+                return std::string_view();
+            }
+            line.remove_prefix(start);
+            size_t length = std::min(line.find_first_of(" \t"), line.size());
+            std::string_view result = line.substr(0, length);
+            line.remove_prefix(length);
+            return result;
+        };
+
+        std::string_view id = word();
+        if (id.empty() || id.front() == '#') continue;
+        std::string_view counterText = word();
+        std::string_view thresholdText = word();
+        size_t titleStart = line.find_first_not_of(" \t");
+        std::string_view title = titleStart == std::string_view::npos ? std::string_view() : line.substr(titleStart);
+
+        Badge badge;
+        badge.id = id;
+        badge.title = title;
+        size_t counter = 0;
+        while (counter < static_cast<size_t>(Counter::COUNT) && counterText != counterName(static_cast<Counter>(counter))) ++counter;
+        auto [next, parseError] = std::from_chars(thresholdText.data(), thresholdText.data() + thresholdText.size(), badge.threshold);
+        if (counter == static_cast<size_t>(Counter::COUNT)) error = "unknown counter \"" + std::string(counterText) + "\"";
+        else if (parseError != std::errc() || next != thresholdText.data() + thresholdText.size() || badge.threshold == 0) error = "bad threshold";
+        else if (title.empty()) error = "missing title";
+        else if (std::any_of(badges.begin(), badges.end(), [&](const Badge& other) { return other.id == badge.id; })) error = "duplicate id";
+        if (!error.empty()) {
+            error = "line " + std::to_string(lineNumber) + ": " + error;
+            return false;
+        }
+        badge.counter = static_cast<Counter>(counter);
+        badges.push_back(std::move(badge));
+    }
+
+    badges_ = std::move(badges);
+    subscribe();
+    return true;
+}
+
+// Rebuilds the per counter subscriptions from what is still locked, unlocks apply to any rule
+// with their id. Counters are fed again by their next update.
+void BadgeEngine::subscribe()
+{
+    for (auto& pending : pending_) pending.clear();
+    next_.fill(0);
+    for (uint32_t i = 0; i < badges_.size(); ++i) {
+        Badge& badge = badges_[i];
+        auto unlocked = unlocked_.find(badge.id);
+        badge.unlockedAt = unlocked == unlocked_.end() ? 0 : unlocked->second;
+        if (!badge.unlockedAt) pending_[static_cast<size_t>(badge.counter)].push_back(i);
+    }
+    for (auto& pending : pending_) {
+        std::stable_sort(pending.begin(), pending.end(), [this](uint32_t a, uint32_t b) { return badges_[a].threshold < badges_[b].threshold; });
+    }
+}
+
+bool BadgeEngine::loadUnlocked(const std::string& path)
+{
+    std::ifstream file(path);
+    if (!file) return false;
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        std::string id;
+        int64_t when = 0;
+        if (fields >> id >> when && when > 0) unlocked_[id] = when;
+    }
+    subscribe();
+    return true;
+}
+
+bool BadgeEngine::saveUnlocked(const std::string& path) const
+{
+    std::ofstream file(path, std::ios::trunc);
+    if (!file) return false;
+    for (const auto& [id, when] : unlocked_) file << id << ' ' << when << '\n';
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace rpc {
+    // Achievements shown in the presence, defined by rules "<id> <counter> <threshold> <title>"
+    // compiled once at load. Each rule subscribes to the one counter it reads: the locked rules of
+    // a counter are kept sorted by threshold with a cursor on the next one, so a counter update
+    // costs one comparison whatever the number of rules and only unlocks advance the cursor.
+    // Unlocks are permanent and persisted by id. EuroScope thread only.
+    class BadgeEngine
+    {
+    public:
+        enum class Counter : uint8_t {
+            SESSION_TRACKS = 0,   // aircraft tracked this session
+            ONLINE_MINUTES,       // since the plugin loaded
+            HANDOFFS_PER_HOUR,    // handoffs in the last hour
+            SWEATBOX_CONNECTIONS, // sweatbox connections this session
+            ON_FIRE,              // times the workload went on fire this session
+            COUNT
+        };
+
+        struct Badge {
+            std::string id;
+            std::string title;
+            Counter counter = Counter::SESSION_TRACKS;
+            uint64_t threshold = 0;
+            int64_t unlockedAt = 0; // unix seconds, 0 while locked
+        };
+
+        static const char* const DEFAULT_RULES;
+
+        // Replaces the rules, false with the first bad line in error; previous unlocks are kept
+        bool compile(std::string_view rules, std::string& error);
+        bool loadUnlocked(const std::string& path);
+        bool saveUnlocked(const std::string& path) const;
+
+        // New value of a counter, calls unlocked(badge) for every rule it satisfies for the first time
+        template <typename Sink>
+        void update(Counter counter, uint64_t value, int64_t nowSeconds, Sink&& unlocked)
+        {
+            size_t index = static_cast<size_t>(counter);
+            values_[index] = value;
+            const std::vector<uint32_t>& pending = pending_[index];
+            size_t& next = next_[index];
+            while (next < pending.size() && badges_[pending[next]].threshold <= value) {
+                Badge& badge = badges_[pending[next++]];
+                badge.unlockedAt = nowSeconds;
+                unlocked_[badge.id] = nowSeconds;
+                unlocked(badge);
+            }
+        }
+
+        const std::vector<Badge>& getBadges() const { return badges_; }
+        uint64_t getValue(Counter counter) const { return values_[static_cast<size_t>(counter)]; }
+
+        static const char* counterName(Counter counter);
+
+    private:
+        void subscribe();
+
+    private:
+        std::vector<Badge> badges_;
+        std::array<std::vector<uint32_t>, static_cast<size_t>(Counter::COUNT)> pending_; // locked badges by threshold
+        std::array<size_t, static_cast<size_t>(Counter::COUNT)> next_{};
+        std::array<uint64_t, static_cast<size_t>(Counter::COUNT)> values_{};
+        std::map<std::string, int64_t> unlocked_; // id to unlock time, includes ids no rule uses anymore
+    };
+} // namespace rpc
@@ -0,0 +1,217 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace rpc {
+    // Callsigns are packed into a 64 bit key (base 40, up to 12 characters, case insensitive)
+    // so that per aircraft / per controller tables never hash or copy strings.
+    // Longer or unusual callsigns fall back to a hash above the packed range and cannot be unpacked.
+    using PackedCallsign = uint64_t;
+
+    constexpr PackedCallsign INVALID_CALLSIGN = 0;
+    constexpr size_t PACKED_CALLSIGN_LENGTH = 12;
+    constexpr uint64_t PACKED_CALLSIGN_RANGE = 16777216000000000000ull; // 40^12
+
+    constexpr uint32_t packCallsignChar(char c)
+    {
+        if (c >= 'A' && c <= 'Z') return static_cast<uint32_t>(c - 'A') + 1;
+        if (c >= 'a' && c <= 'z') return static_cast<uint32_t>(c - 'a') + 1;
+        if (c >= '0' && c <= '9') return static_cast<uint32_t>(c - '0') + 27;
+        if (c == '_') return 37;
+        if (c == '-') return 38;
+        return 0;
+    }
+
+    constexpr PackedCallsign hashCallsign(const char* callsign, size_t length)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        for (size_t i = 0; i < length; ++i) {
+            char c = callsign[i];
+            if (c >= 'a' && c <= 'z') c = static_cast<char>(c - 'a' + 'A');
+            hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+        }
+        return PACKED_CALLSIGN_RANGE + hash % (UINT64_MAX - PACKED_CALLSIGN_RANGE);
+    }
+
+    constexpr PackedCallsign packCallsign(const char* callsign, size_t length)
+    {
+        if (callsign == nullptr || length == 0) return INVALID_CALLSIGN;
+        if (length > PACKED_CALLSIGN_LENGTH) return hashCallsign(callsign, length);
+
+        uint64_t packed = 0;
+        for (size_t i = 0; i < length; ++i) {
+            uint32_t code = packCallsignChar(callsign[i]);
+            if (code == 0) return hashCallsign(callsign, length);
+            packed = packed * 40 + code;
+        }
+        return packed;
+    }
+
+    constexpr PackedCallsign packCallsign(const char* callsign)
+    {
+        if (callsign == nullptr) return INVALID_CALLSIGN;
+        size_t length = 0;
+        while (callsign[length] != '\0') ++length;
+        return packCallsign(callsign, length);
+    }
+
+    inline PackedCallsign packCallsign(const std::string& callsign)
+    {
+        return packCallsign(callsign.data(), callsign.size());
+    }
+
+    // Writes the upper case callsign into buffer (at least PACKED_CALLSIGN_LENGTH + 1 bytes), returns its length
+    inline size_t unpackCallsign(PackedCallsign packed, char* buffer)
+    {
+        static constexpr char alphabet[] = "?ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_-?";
+        if (packed == INVALID_CALLSIGN || packed >= PACKED_CALLSIGN_RANGE) {
+            buffer[0] = '\0';
+            return 0;
+        }
+
+        char reversed[PACKED_CALLSIGN_LENGTH];
+        size_t length = 0;
+        while (packed != 0) {
+            reversed[length++] = alphabet[packed % 40];
+            packed /= 40;
+        }
+        for (size_t i = 0; i < length; ++i) buffer[i] = reversed[length - 1 - i];
+        buffer[length] = '\0';
+        return length;
+    }
+
+    inline std::string unpackCallsign(PackedCallsign packed)
+    {
+        char buffer[PACKED_CALLSIGN_LENGTH + 1];
+        size_t length = unpackCallsign(packed, buffer);
+        return std::string(buffer, length);
+    }
+
+    // Open addressing (linear probing, backward shift deletion) table keyed by packed callsign.
+    // A lookup is a multiply, a mask and usually a single probe. Not thread safe.
+    template <typename T>
+    class CallsignMap
+    {
+    public:
+        explicit CallsignMap(size_t initialCapacity = 64)
+        {
+            size_t capacity = 16;
+            while (capacity < initialCapacity) capacity <<= 1;
+            keys_.assign(capacity, INVALID_CALLSIGN);
+            values_.resize(capacity);
+        }
+
+        size_t size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+
+        T* find(PackedCallsign key)
+        {
+            if (key == INVALID_CALLSIGN) return nullptr;
+            size_t mask = keys_.size() - 1;
+            for (size_t i = slot(key); ; i = (i + 1) & mask) {
+                if (keys_[i] == key) return &values_[i];
+                if (keys_[i] == INVALID_CALLSIGN) return nullptr;
+            }
+        }
+
+        const T* find(PackedCallsign key) const
+        {
+            return const_cast<CallsignMap*>(this)->find(key);
+        }
+
+        // Returns the value for key, default constructing it if missing. second is true when inserted.
+        std::pair<T*, bool> tryEmplace(PackedCallsign key)
+        {
+            if (key == INVALID_CALLSIGN) return { nullptr, false };
+            if ((size_ + 1) * 10 > keys_.size() * 7) grow();
+
+            size_t mask = keys_.size() - 1;
+            for (size_t i = slot(key); ; i = (i + 1) & mask) {
+                if (keys_[i] == key) return { &values_[i], false };
+                if (keys_[i] == INVALID_CALLSIGN) {
+                    keys_[i] = key;
+                    values_[i] = T{};
+                    ++size_;
+                    return { &values_[i], true };
+                }
+            }
+        }
+
+        bool erase(PackedCallsign key)
+        {
+            if (key == INVALID_CALLSIGN) return false;
+            size_t mask = keys_.size() - 1;
+            size_t i = slot(key);
+            while (keys_[i] != key) {
+                if (keys_[i] == INVALID_CALLSIGN) return false;
+                i = (i + 1) & mask;
+            }
+
+            // Shift the following cluster back so lookups never need tombstones
+            for (size_t j = (i + 1) & mask; keys_[j] != INVALID_CALLSIGN; j = (j + 1) & mask) {
+                size_t home = slot(keys_[j]);
+                bool movable = (i <= j) ? (home <= i || home > j) : (home <= i && home > j);
+                if (movable) {
+                    keys_[i] = keys_[j];
+                    values_[i] = std::move(values_[j]);
+                    i = j;
+                }
+            }
+            keys_[i] = INVALID_CALLSIGN;
+            values_[i] = T{};
+            --size_;
+            return true;
+        }
+
+        void clear()
+        {
+            std::fill(keys_.begin(), keys_.end(), INVALID_CALLSIGN);
+            std::fill(values_.begin(), values_.end(), T{});
+            size_ = 0;
+        }
+
+        template <typename Fn>
+        void forEach(Fn&& fn)
+        {
+            for (size_t i = 0; i < keys_.size(); ++i)
+                if (keys_[i] != INVALID_CALLSIGN) fn(keys_[i], values_[i]);
+        }
+
+        template <typename Fn>
+        void forEach(Fn&& fn) const
+        {
+            for (size_t i = 0; i < keys_.size(); ++i)
+                if (keys_[i] != INVALID_CALLSIGN) fn(keys_[i], values_[i]);
+        }
+
+    private:
+        size_t slot(PackedCallsign key) const
+        {
+            // Fibonacci hashing spreads the base 40 digits over the whole table
+            return static_cast<size_t>((key * 11400714819323198485ull) >> 32) & (keys_.size() - 1);
+        }
+
+        void grow()
+        {
+            std::vector<PackedCallsign> oldKeys = std::move(keys_);
+            std::vector<T> oldValues = std::move(values_);
+            keys_.assign(oldKeys.size() * 2, INVALID_CALLSIGN);
+            values_.clear();
+            values_.resize(oldKeys.size() * 2);
+            size_ = 0;
+            for (size_t i = 0; i < oldKeys.size(); ++i) {
+                if (oldKeys[i] == INVALID_CALLSIGN) continue;
+                *tryEmplace(oldKeys[i]).first = std::move(oldValues[i]);
+            }
+        }
+
+    private:
+        std::vector<PackedCallsign> keys_;
+        std::vector<T> values_;
+        size_t size_ = 0;
+    };
+} // namespace rpc
@@ -0,0 +1,80 @@
+#include "CommsStats.h"
+#include <algorithm>
+
+using namespace rpc;
+
+namespace {
+    uint64_t hashMessage(const char* message)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        for (const char* c = message; c && *c; ++c)
+            hash = (hash ^ static_cast<uint8_t>(*c)) * 1099511628211ull;
+        return hash;
+    }
+}
+
+void CommsStats::recordFrequencyMessage(const char* sender, const char* message, int64_t nowSeconds)
+{
+    PackedCallsign callsign = packCallsign(sender);
+    if (isDuplicate(callsign, message, nowSeconds)) return;
+
+    frequencyRate_.record(nowSeconds);
+    totalMessages_.fetch_add(1, std::memory_order_relaxed);
+    countSender(callsign);
+}
+
+void CommsStats::recordPrivateMessage(const char* sender, const char* message, int64_t nowSeconds)
+{
+    PackedCallsign callsign = packCallsign(sender);
+    privateRate_.record(nowSeconds);
+    totalMessages_.fetch_add(1, std::memory_order_relaxed);
+    countSender(callsign);
+}
+
+void CommsStats::reset()
+{
+    frequencyRate_.reset();
+    privateRate_.reset();
+    totalMessages_ = 0;
+    senders_ = {};
+    lastSender_ = INVALID_CALLSIGN;
+    lastMessageHash_ = 0;
+    lastMessageTime_ = 0;
+}
+
+std::array<CommsStats::Sender, CommsStats::TOP_SENDERS> CommsStats::topSenders() const
+{
+    std::array<Sender, TOP_SENDERS> sorted = senders_;
+    std::sort(sorted.begin(), sorted.end(), [](const Sender& a, const Sender& b) { return a.count > b.count; });
+    return sorted;
+}
+
+bool CommsStats::isDuplicate(PackedCallsign sender, const char* message, int64_t nowSeconds)
+{
+    // EuroScope calls the frequency handler once per frequency the message was sent on
+    uint64_t hash = hashMessage(message);
+    bool duplicate = sender == lastSender_ && hash == lastMessageHash_ && nowSeconds == lastMessageTime_;
+    lastSender_ = sender;
+    lastMessageHash_ = hash;
+    lastMessageTime_ = nowSeconds;
+    return duplicate;
+}
+
+void CommsStats::countSender(PackedCallsign sender)
+{
+    if (sender == INVALID_CALLSIGN) return;
+
+    Sender* smallest = &senders_[0];
+    for (Sender& slot : senders_) {
+        if (slot.callsign == sender) {
+            ++slot.count;
+            return;
+        }
+        if (slot.count < smallest->count) smallest = &slot;
+    }
+
+    // Space-Saving: take over the least counted slot, inheriting its count as error bound
+    smallest->error = smallest->count;
+    smallest->callsign = sender;
+    ++smallest->count;
+}
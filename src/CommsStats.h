@@ -0,0 +1,51 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include "Callsign.h"
+#include "RateCounter.h"
+
+namespace rpc {
+    // Text communication statistics from frequency and private chat callbacks.
+    // Rates come from bucketed sliding windows, the busiest senders are tracked with the
+    // Space-Saving algorithm in a fixed number of slots. The callback path only packs the sender
+    // callsign and hashes the message to drop the copies EuroScope sends for every frequency.
+    class CommsStats
+    {
+    public:
+        static constexpr size_t TOP_SENDERS = 8;
+
+        struct Sender {
+            PackedCallsign callsign = INVALID_CALLSIGN;
+            uint32_t count = 0;
+            uint32_t error = 0; // overestimation bound inherited from the evicted slot
+        };
+
+        void recordFrequencyMessage(const char* sender, const char* message, int64_t nowSeconds);
+        void recordPrivateMessage(const char* sender, const char* message, int64_t nowSeconds);
+        void reset();
+
+        // Any thread
+        double frequencyPerMinute(int64_t nowSeconds) const { return frequencyRate_.perMinute(nowSeconds); }
+        double privatePerMinute(int64_t nowSeconds) const { return privateRate_.perMinute(nowSeconds); }
+        uint64_t getTotalMessages() const { return totalMessages_.load(std::memory_order_relaxed); }
+
+        // Busiest senders, highest count first. Same thread as the record calls.
+        std::array<Sender, TOP_SENDERS> topSenders() const;
+
+    private:
+        bool isDuplicate(PackedCallsign sender, const char* message, int64_t nowSeconds);
+        void countSender(PackedCallsign sender);
+
+    private:
+        RateCounter<12> frequencyRate_{ 5 }; // one minute window, 5 second buckets
+        RateCounter<12> privateRate_{ 5 };
+        std::atomic<uint64_t> totalMessages_{ 0 };
+
+        std::array<Sender, TOP_SENDERS> senders_{};
+
+        PackedCallsign lastSender_ = INVALID_CALLSIGN;
+        uint64_t lastMessageHash_ = 0;
+        int64_t lastMessageTime_ = 0;
+    };
+} // namespace rpc
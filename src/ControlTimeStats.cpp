@@ -0,0 +1,108 @@
+#include "ControlTimeStats.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <set>
+#include <vector>
+
+using namespace rpc;
+
+void ControlTimeStats::record(const std::string& position, uint64_t seconds)
+{
+    session_.record(seconds);
+    if (!position.empty()) positions_[position].record(seconds);
+}
+
+void ControlTimeStats::allTime(const std::string& position, LatencyHistogram& out) const
+{
+    if (auto it = persisted_.find(position); it != persisted_.end()) out.merge(it->second);
+    if (auto it = positions_.find(position); it != positions_.end()) out.merge(it->second);
+}
+
+bool ControlTimeStats::load(const std::string& path)
+{
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) return false;
+
+    std::map<std::string, LatencyHistogram> loaded;
+    FileHeader header;
+    bool valid = std::fread(&header, sizeof(header), 1, file) == 1 && header.magic == FILE_MAGIC && header.version == FILE_VERSION;
+    for (uint32_t i = 0; valid && i < header.positions; ++i) {
+        PositionHeader position;
+        if (std::fread(&position, sizeof(position), 1, file) != 1 || position.buckets > LatencyHistogram::BUCKETS) {
+            valid = false;
+            break;
+        }
+        LatencyHistogram::Snapshot snapshot;
+        snapshot.count = position.count;
+        snapshot.sum = position.sum;
+        snapshot.max = position.max;
+        for (uint32_t j = 0; j < position.buckets; ++j) {
+            Bucket bucket;
+            if (std::fread(&bucket, sizeof(bucket), 1, file) != 1 || bucket.index >= LatencyHistogram::BUCKETS) {
+                valid = false;
+                break;
+            }
+            snapshot.counts[bucket.index] = bucket.count;
+        }
+        position.name[sizeof(position.name) - 1] = '\0';
+        if (valid) loaded[position.name].merge(snapshot);
+    }
+    std::fclose(file);
+    if (!valid) return false;
+
+    persisted_.clear();
+    for (auto& [name, histogram] : loaded) persisted_[name].merge(histogram);
+    return true;
+}
+
+bool ControlTimeStats::save(const std::string& path) const
+{
+    std::set<std::string> names;
+    for (const auto& entry : persisted_) names.insert(entry.first);
+    for (const auto& entry : positions_) names.insert(entry.first);
+
+    // Written aside then renamed, a crash mid write keeps the previous figures
+    std::string temporary = path + ".tmp";
+    FILE* file = std::fopen(temporary.c_str(), "wb");
+    if (!file) return false;
+
+    FileHeader header{ FILE_MAGIC, FILE_VERSION, static_cast<uint32_t>(names.size()), 0 };
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1;
+    for (const std::string& name : names) {
+        LatencyHistogram merged;
+        allTime(name, merged);
+        LatencyHistogram::Snapshot snapshot = merged.snapshot();
+
+        std::vector<Bucket> buckets;
+        for (uint32_t i = 0; i < LatencyHistogram::BUCKETS; ++i) {
+            if (snapshot.counts[i]) buckets.push_back({ i, 0, snapshot.counts[i] });
+        }
+        PositionHeader position = {};
+        std::strncpy(position.name, name.c_str(), sizeof(position.name) - 1);
+        position.count = snapshot.count;
+        position.sum = snapshot.sum;
+        position.max = snapshot.max;
+        position.buckets = static_cast<uint32_t>(buckets.size());
+        ok = ok && std::fwrite(&position, sizeof(position), 1, file) == 1
+            && (buckets.empty() || std::fwrite(buckets.data(), sizeof(Bucket), buckets.size(), file) == buckets.size());
+    }
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    // Replaces the previous file in one step, there is no moment without one
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+    return !error;
+}
+
+std::string ControlTimeStats::formatDuration(uint64_t seconds)
+{
+    char text[24];
+    if (seconds < 60) std::snprintf(text, sizeof(text), "%llus", static_cast<unsigned long long>(seconds));
+    else if (seconds < 3600) std::snprintf(text, sizeof(text), "%llum", static_cast<unsigned long long>(seconds / 60));
+    else std::snprintf(text, sizeof(text), "%lluh%02llu", static_cast<unsigned long long>(seconds / 3600), static_cast<unsigned long long>(seconds / 60 % 60));
+    return text;
+}
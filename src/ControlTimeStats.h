@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <string>
+#include "LatencyHistogram.h"
+
+namespace rpc {
+    // How long aircraft stay under my control, in seconds: one histogram for the session, one per
+    // position controlled in it, and the all-time histograms of earlier sessions loaded from disk.
+    // Saving merges the session into the all-time figures. EuroScope thread only.
+    class ControlTimeStats
+    {
+    public:
+        static constexpr uint32_t FILE_MAGIC = 0x53544345; // "ECTS"
+        static constexpr uint32_t FILE_VERSION = 1;
+
+        // position may be empty when I have no callsign, the interval then only counts for the session
+        void record(const std::string& position, uint64_t seconds);
+
+        const LatencyHistogram& getSession() const { return session_; }
+        const std::map<std::string, LatencyHistogram>& getSessionPositions() const { return positions_; }
+        // Earlier sessions plus this one
+        void allTime(const std::string& position, LatencyHistogram& out) const;
+
+        bool load(const std::string& path);
+        bool save(const std::string& path) const;
+
+        // "45s", "12m", "1h05"
+        static std::string formatDuration(uint64_t seconds);
+
+    private:
+        struct FileHeader {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t positions;
+            uint32_t reserved;
+        };
+
+        // Per position: name, totals, then buckets non empty buckets
+        struct PositionHeader {
+            char name[16];
+            uint64_t count;
+            uint64_t sum;
+            uint64_t max;
+            uint32_t buckets;
+            uint32_t reserved;
+        };
+
+        struct Bucket {
+            uint32_t index;
+            uint32_t reserved;
+            uint64_t count;
+        };
+
+    private:
+        LatencyHistogram session_;
+        std::map<std::string, LatencyHistogram> positions_;
+        std::map<std::string, LatencyHistogram> persisted_;
+    };
+} // namespace rpc
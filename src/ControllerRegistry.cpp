@@ -0,0 +1,143 @@
+#include "ControllerRegistry.h"
+
+using namespace rpc;
+
+namespace {
+    int clampFacility(int facility)
+    {
+        return (facility < 0 || facility >= ControllerRegistry::FACILITY_COUNT) ? 0 : facility;
+    }
+}
+
+void ControllerRegistry::update(const Controller& controller)
+{
+    if (controller.callsign == INVALID_CALLSIGN) return;
+
+    Controller record = controller;
+    record.facility = clampFacility(record.facility);
+
+    auto [index, inserted] = indices_.tryEmplace(record.callsign);
+    if (inserted) {
+        *index = static_cast<uint32_t>(controllers_.size());
+        controllers_.push_back(record);
+        nearby_.push_back(0);
+        positions_.push_back(record.latitude, record.longitude);
+        facilityCounts_[record.facility].fetch_add(1, std::memory_order_relaxed);
+    }
+    else {
+        Controller& current = controllers_[*index];
+        if (current.facility != record.facility) {
+            facilityCounts_[current.facility].fetch_sub(1, std::memory_order_relaxed);
+            facilityCounts_[record.facility].fetch_add(1, std::memory_order_relaxed);
+        }
+        current = record;
+        positions_.set(*index, record.latitude, record.longitude);
+    }
+
+    setNearby(*index, isNearby(*index));
+}
+
+void ControllerRegistry::remove(PackedCallsign callsign)
+{
+    uint32_t* found = indices_.find(callsign);
+    if (!found) return;
+
+    size_t index = *found;
+    setNearby(index, false);
+    facilityCounts_[controllers_[index].facility].fetch_sub(1, std::memory_order_relaxed);
+
+    size_t last = controllers_.size() - 1;
+    if (index != last) {
+        controllers_[index] = controllers_[last];
+        nearby_[index] = nearby_[last];
+        *indices_.find(controllers_[index].callsign) = static_cast<uint32_t>(index);
+    }
+    positions_.swapRemove(index);
+    controllers_.pop_back();
+    nearby_.pop_back();
+    indices_.erase(callsign);
+}
+
+void ControllerRegistry::reset()
+{
+    controllers_.clear();
+    nearby_.clear();
+    positions_.clear();
+    indices_.clear();
+    for (auto& count : facilityCounts_) count = 0;
+    nearbyCount_ = 0;
+}
+
+void ControllerRegistry::setReference(PackedCallsign self, double latitude, double longitude, double rangeNm)
+{
+    if (self == self_ && latitude == referenceLatitude_ && longitude == referenceLongitude_ && rangeNm == referenceRangeNm_)
+        return;
+
+    self_ = self;
+    referenceLatitude_ = latitude;
+    referenceLongitude_ = longitude;
+    referenceRangeNm_ = rangeNm;
+    nearbyFilter_ = geo::RangeFilter(latitude, longitude, rangeNm);
+    for (size_t i = 0; i < controllers_.size(); ++i) setNearby(i, isNearby(i));
+}
+
+const ControllerRegistry::Controller* ControllerRegistry::find(PackedCallsign callsign) const
+{
+    const uint32_t* index = indices_.find(callsign);
+    return index ? &controllers_[*index] : nullptr;
+}
+
+const ControllerRegistry::Controller* ControllerRegistry::nearest(double latitude, double longitude, double* distanceNm) const
+{
+    if (controllers_.empty()) return nullptr;
+    distances_.resize(controllers_.size());
+    geo::distancesNm(latitude, longitude, positions_, distances_.data());
+
+    const Controller* best = nullptr;
+    float bestDistance = 0.0f;
+    for (size_t i = 0; i < controllers_.size(); ++i) {
+        const Controller& controller = controllers_[i];
+        if (controller.facility == 0 || controller.callsign == self_) continue;
+        if (!best || distances_[i] < bestDistance) {
+            best = &controller;
+            bestDistance = distances_[i];
+        }
+    }
+    if (distanceNm) *distanceNm = bestDistance;
+    return best;
+}
+
+uint32_t ControllerRegistry::countWithin(double latitude, double longitude, double rangeNm) const
+{
+    if (controllers_.empty()) return 0;
+    distances_.resize(controllers_.size());
+    geo::distancesNm(latitude, longitude, positions_, distances_.data());
+
+    uint32_t count = 0;
+    for (size_t i = 0; i < controllers_.size(); ++i) {
+        const Controller& controller = controllers_[i];
+        if (controller.facility != 0 && controller.callsign != self_ && distances_[i] <= rangeNm) ++count;
+    }
+    return count;
+}
+
+uint32_t ControllerRegistry::getFacilityCount(int facility) const
+{
+    if (facility < 0 || facility >= FACILITY_COUNT) return 0;
+    return facilityCounts_[facility].load(std::memory_order_relaxed);
+}
+
+bool ControllerRegistry::isNearby(size_t index) const
+{
+    const Controller& controller = controllers_[index];
+    if (self_ == INVALID_CALLSIGN || controller.facility == 0 || controller.callsign == self_) return false;
+    return nearbyFilter_.contains(positions_, index);
+}
+
+void ControllerRegistry::setNearby(size_t index, bool nearby)
+{
+    if (static_cast<bool>(nearby_[index]) == nearby) return;
+    nearby_[index] = nearby ? 1 : 0;
+    if (nearby) nearbyCount_.fetch_add(1, std::memory_order_relaxed);
+    else nearbyCount_.fetch_sub(1, std::memory_order_relaxed);
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include "Callsign.h"
+#include "GeoBatch.h"
+
+namespace rpc {
+    // Online controllers maintained from controller position updates and disconnects.
+    // Records live in dense arrays (swap removal) indexed by packed callsign, facility counts and
+    // the number of controllers around my own position are kept up to date on every event.
+    class ControllerRegistry
+    {
+    public:
+        static constexpr int FACILITY_COUNT = 7; // OBS, FSS, DEL, GND, TWR, APP, CTR
+
+        struct Controller {
+            PackedCallsign callsign = INVALID_CALLSIGN;
+            int facility = 0;
+            int rating = 0;
+            int frequencyKhz = 0;
+            double latitude = 0.0;
+            double longitude = 0.0;
+        };
+
+        void update(const Controller& controller);
+        void remove(PackedCallsign callsign);
+        void reset();
+
+        // My own position and visibility range, nearby counts are recomputed only when it changes
+        void setReference(PackedCallsign self, double latitude, double longitude, double rangeNm);
+
+        const Controller* find(PackedCallsign callsign) const;
+        // Closest controller (facility above OBS) to the given point, nullptr when none
+        const Controller* nearest(double latitude, double longitude, double* distanceNm = nullptr) const;
+        uint32_t countWithin(double latitude, double longitude, double rangeNm) const;
+        size_t size() const { return controllers_.size(); }
+
+        // Safe to call from any thread
+        uint32_t getFacilityCount(int facility) const;
+        uint32_t getNearbyCount() const { return nearbyCount_.load(std::memory_order_relaxed); }
+
+    private:
+        bool isNearby(size_t index) const;
+        void setNearby(size_t index, bool nearby);
+
+    private:
+        std::vector<Controller> controllers_;
+        std::vector<uint8_t> nearby_;
+        geo::PointBatch positions_; // parallel to controllers_, feeds the batched distance kernel
+        mutable std::vector<float> distances_;
+        CallsignMap<uint32_t> indices_{ 128 };
+
+        PackedCallsign self_ = INVALID_CALLSIGN;
+        double referenceLatitude_ = 0.0;
+        double referenceLongitude_ = 0.0;
+        double referenceRangeNm_ = 0.0;
+        geo::RangeFilter nearbyFilter_; // one distance test for position updates and reference changes
+
+        std::array<std::atomic<uint32_t>, FACILITY_COUNT> facilityCounts_{};
+        std::atomic<uint32_t> nearbyCount_{ 0 };
+    };
+} // namespace rpc
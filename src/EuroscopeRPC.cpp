@@ -2,12 +2,18 @@
 #include <numeric>
 #include <chrono>
 #include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iterator>
 
 #include "Version.h"
 
 using namespace rpc;
 
-EuroscopeRPC::EuroscopeRPC() : CPlugIn(EuroScopePlugIn::COMPATIBILITY_CODE, "EuroscopeRPC", PLUGIN_VERSION, "Alexis Balzano", "Open Source"), m_stop(false)
+EuroscopeRPC::EuroscopeRPC() : CPlugIn(EuroScopePlugIn::COMPATIBILITY_CODE, PLUGIN_NAME, PLUGIN_VERSION, "Alexis Balzano", "Open Source"), m_stop(false)
 {
     Initialize();
 };
@@ -34,6 +40,15 @@ void __declspec (dllexport) EuroScopePlugInExit()
 void EuroscopeRPC::Initialize()
 {
     StartTime = time(nullptr);
+    tagNow_ = StartTime;
+    RegisterTagItemType("Tracking duration", TAG_ITEM_TRACKING_DURATION);
+    RegisterTagItemType("Session track status", TAG_ITEM_SESSION_TRACK_STATUS);
+    registerSessionList();
+    controlTimes_.load(pluginDirectory() + CONTROL_TIMES_FILE);
+    loadBadges();
+    rebuildRunways(); // loaded mid session, EuroScope reports only later changes
+    PluginState::copy(state_.idlingText, "Watching the skies");
+    sharedState_.store(state_);
 
     try
     {
@@ -44,6 +59,7 @@ void EuroscopeRPC::Initialize()
 		DisplayMessage("Failed to initialize EuroscopeRPC: " + std::string(e.what()), "Error");
     }
     m_stop = false;
+    sharedPresence_.open();
     m_thread = std::thread(&EuroscopeRPC::run, this);
 	DisplayMessage("EuroscopeRPC initialized successfully", "Status");
 }
@@ -53,13 +69,22 @@ void EuroscopeRPC::Shutdown()
     if (initialized_)
     {
         initialized_ = false;
-        trackedCallsigns_.clear();
+        sessionTracks_.reset();
+        endAllTracks();
+        if (!controlTimes_.save(pluginDirectory() + CONTROL_TIMES_FILE))
+            DisplayMessage("Failed to save time under control statistics", "Error");
     }
     m_stop = true;
+    wakePresence();
     if (m_thread.joinable())
         m_thread.join();
+    sharedPresence_.close();
+    session_.stop();
+
+    dumpRecorder("EuroscopeRPC-last.blackbox");
 
 	DisplayMessage("EuroscopeRPC shutdown complete", "Status");
+    flushMessages();
 }
 
 void rpc::EuroscopeRPC::Reset()
@@ -67,7 +92,14 @@ void rpc::EuroscopeRPC::Reset()
 }
 
 void EuroscopeRPC::DisplayMessage(const std::string &message, const std::string &sender) {
-    DisplayUserMessage("EuroscopeRPC", sender.c_str(), message.c_str(), true, true, false, false, false);
+    messages_.push(sender, message, std::time(nullptr));
+}
+
+// EuroScope thread only, the SDK is never called from the worker or Discord threads
+void EuroscopeRPC::flushMessages() {
+    messages_.drain(std::time(nullptr), [this](const std::string& sender, const std::string& message) {
+        DisplayUserMessage("EuroscopeRPC", sender.c_str(), message.c_str(), true, true, false, false, false);
+    });
 }
 
 void rpc::EuroscopeRPC::discordSetup()
@@ -75,12 +107,17 @@ void rpc::EuroscopeRPC::discordSetup()
     discord::RPCManager::get()
         .setClientID(APPLICATION_ID)
         .onReady([this](discord::User const& user) {
+        recorder_.record(FlightRecorder::EventType::DISCORD_READY);
+        resendPresence_ = true;
+        wakePresence();
 		DisplayMessage("Connected to Discord as " + user.username + "#" + user.discriminator, "Discord");
             })
         .onDisconnected([this](int errcode, std::string_view message) {
+        recorder_.record(FlightRecorder::EventType::DISCORD_DISCONNECTED, 0, static_cast<uint32_t>(errcode));
 		DisplayMessage("Disconnected from Discord: " + std::to_string(errcode) + " - " + std::string(message), "Discord");
             })
         .onErrored([this](int errcode, std::string_view message) {
+        recorder_.record(FlightRecorder::EventType::DISCORD_ERROR, 0, static_cast<uint32_t>(errcode));
 		DisplayMessage("Discord error: " + std::to_string(errcode) + " - " + std::string(message), "Discord");
             });
 }
@@ -113,7 +150,15 @@ void rpc::EuroscopeRPC::changeIdlingText()
         "Arguing that France is not on strike"
     };
 
-    idlingText_ = std::string(idlingTexts[counter % idlingTexts.size()]);
+    PluginState::copy(state_.idlingText, idlingTexts[counter % idlingTexts.size()]);
+    noteChange(ChangeCause::IDLE_ROTATION, FlightRecorder::now());
+}
+
+std::string rpc::EuroscopeRPC::airportOf(const std::string& callsign)
+{
+    // LFPG_TWR, LFPG_N_APP -> LFPG
+    size_t separator = callsign.find('_');
+    return separator == 4 ? callsign.substr(0, 4) : std::string();
 }
 
 void rpc::EuroscopeRPC::updatePresence()
@@ -121,171 +166,924 @@ void rpc::EuroscopeRPC::updatePresence()
     auto& rpc = discord::RPCManager::get();
     if (!m_presence) {
         rpc.clearPresence();
+        recorder_.record(FlightRecorder::EventType::PRESENCE_SUPPRESSED, static_cast<uint16_t>(FlightRecorder::SuppressReason::DISABLED));
+        acknowledgeChange(sharedState_.load(), false);
+        lastFrame_ = PresenceFrame{};
+        presenceSettled_ = true;
         return;
     }
 
-    std::string controller = idlingText_;
-	std::string state = "Idling";
-
-    switch (connectionType_) {
-    case State::CONTROLLING:
-        controller = "Controlling " + currentController_ + " " + currentFrequency_;
-        state = "Aircraft tracked: " + std::to_string(aircraftTracked_) + " of " + std::to_string(totalAircrafts_);
-        rpc.getPresence().setSmallImageKey("radarlogo");
-        break;
-    case State::OBSERVING:
-        controller = "Observing as " + currentController_;
-        state = "Aircraft in range: " + std::to_string(totalAircrafts_);
-        rpc.getPresence().setSmallImageKey("");
-        break;
-    case State::SWEATBOX:
-        controller = "In Sweatbox";
-        state = "Aircraft tracked: (" + std::to_string(aircraftTracked_) + " of " + std::to_string(totalAircrafts_) + ")";
-        rpc.getPresence().setSmallImageKey("radarlogo");
-        break;
-    case State::PLAYBACK:
-        controller = "In Playback";
-        state = "Aircraft in range: " + std::to_string(totalAircrafts_);
-        rpc.getPresence().setSmallImageKey("");
-        break;
-    default:
-        rpc.getPresence().setSmallImageKey("");
-        break;
+    PresenceInput input;
+    input.state = sharedState_.load();
+    const PluginState& current = input.state;
+    int64_t now = std::time(nullptr);
+    if (current.connectionType == State::CONTROLLING)
+        input.inboundSoon = sectorForecast_.inboundWithin(FORECAST_MINUTES, now / 60);
+    input.aircraftInRange = aircraftInRange(current.totalAircrafts);
+    HandoffTracker::Counters handoffs = handoffTracker_.getCounters();
+    input.handoffsIn = handoffs.inbound;
+    input.handoffsOut = handoffs.outbound;
+    input.transmissions = voiceStats_.getTransmissions();
+    input.messagesPerMinute = static_cast<int>(commsStats_.frequencyPerMinute(now) + commsStats_.privatePerMinute(now) + 0.5);
+    input.nearbyControllers = controllerRegistry_.getNearbyCount();
+    for (size_t i = 0; i < input.movementsPerHour.size(); ++i)
+        input.movementsPerHour[i] = movements_.perHour(static_cast<MovementCounters::Movement>(i), now);
+    if (current.connectionType == State::CONTROLLING) {
+        // "LFPG 27L/26R Q1013, wind 250/12", either half alone when the other is unknown
+        std::string airport = airportOf(current.callsign);
+        std::string weather;
+        if (std::optional<Metar> metar = metarCache_.find(airport); metar) weather = formatMetar(*metar);
+        if (current.runways[0] != '\0') airport += " " + std::string(current.runways);
+        if (!weather.empty()) input.weather = airport + " " + weather;
+        else if (current.runways[0] != '\0') input.weather = airport;
     }
+    input.merged = sharedPresence_.merge();
 
-    std::string imageKey = "";
-	std::string imageText = "";
-
-    switch (tier_) {
-        case Tier::SILVER:
-            imageKey = "silver";
-            imageText = "On a " + std::to_string(onlineTime_) + " hour streak";
-            break;
-        case Tier::GOLD:
-            if (imageKey.empty()) imageKey = "gold";
-            imageText = "On a " + std::to_string(onlineTime_) + " hour streak";
-			break;
-        case Tier::NONE:
-        default:
-            imageKey = "main";
-            imageText = "French VACC";
-			break;
+    PresenceFrame frame = formatPresence(input);
+    bool resend = resendPresence_.exchange(false);
+    presenceSettled_ = frame == lastFrame_ && !resend;
+    if (presenceSettled_) {
+        acknowledgeChange(current, false);
+        return;
+    }
+    if (!discordBudget_.tryTake(FlightRecorder::now())) {
+        if (resend) resendPresence_ = true;
+        recorder_.record(FlightRecorder::EventType::PRESENCE_SUPPRESSED, static_cast<uint16_t>(FlightRecorder::SuppressReason::RATE_LIMITED));
+        return;
     }
-
-    if (isOnFire_) {
-        imageKey += "fire";
-        if (!imageText.empty()) imageText += " ";
-        imageText += "On Fire!";
-	}
-
-    if (imageKey.empty()) imageKey = "main";
-	if (imageText.empty()) imageText = "French VACC";
-
 
     rpc.getPresence()
-        .setState(state)
-		.setLargeImageKey(imageKey)
-		.setLargeImageText(imageText)
+        .setState(frame.state)
+		.setLargeImageKey(frame.largeImageKey)
+		.setLargeImageText(frame.largeImageText)
         .setActivityType(discord::ActivityType::Game)
         .setStatusDisplayType(discord::StatusDisplayType::Name)
-        .setDetails(controller)
+        .setDetails(frame.details)
         .setStartTimestamp(StartTime)
-        .setSmallImageText("Total Tracks: " + std::to_string(totalTracks_))
+        .setSmallImageKey(frame.smallImageKey)
+        .setSmallImageText(frame.smallImageText)
         .setInstance(true)
         .refresh();
+    recorder_.record(FlightRecorder::EventType::PRESENCE_SENT, 0, FlightRecorder::hashText(frame.details + frame.state + frame.smallImageText));
+    acknowledgeChange(current, true);
+    lastFrame_ = std::move(frame);
 }
 
-void rpc::EuroscopeRPC::updateData()
+// True when something the presence shows changed, the polling cadence follows it
+bool rpc::EuroscopeRPC::updateData()
 {
+    int connectionBefore = state_.connectionType;
+    int tierBefore = state_.tier;
 	updateConnectionType();
-	getAicraftCount();
+    const char* runways = myAirport_.empty() ? nullptr : runways_.find(myAirport_);
+    bool runwaysChanged = std::strcmp(state_.runways, runways ? runways : "") != 0;
+    if (runwaysChanged) PluginState::copy(state_.runways, runways ? runways : "");
 
-	if (std::time(nullptr) - StartTime > 2 * HOUR_THRESHOLD) tier_ = Tier::GOLD;
-    else if (std::time(nullptr) - StartTime > HOUR_THRESHOLD) tier_ = Tier::SILVER;
-	else tier_ = Tier::NONE;
+    uint32_t trackedBefore = state_.aircraftTracked;
+    uint32_t tracksBefore = state_.totalTracks;
+    // Both counts are kept by the callbacks, no radar target walk here
+    state_.totalAircrafts = static_cast<uint32_t>(targetGrid_.size());
+    state_.aircraftTracked = static_cast<uint32_t>(trackTimer_.size());
+    bool tracksChanged = state_.aircraftTracked != trackedBefore || state_.totalTracks != tracksBefore;
+    if (tracksChanged)
+        noteChange(ChangeCause::TRACK_CHANGE, trackChangeNs_ ? trackChangeNs_ : FlightRecorder::now());
+    trackChangeNs_ = 0;
 
-	onlineTime_ = static_cast<int>((std::time(nullptr) - StartTime) / 3600); // in hours
-    isOnFire_ = (aircraftTracked_ >= ONFIRE_THRESHOLD);
+	state_.tier = tierFor(std::time(nullptr) - StartTime);
+
+	state_.onlineTime = static_cast<int>((std::time(nullptr) - StartTime) / 3600); // in hours
+    updateBadge(BadgeEngine::Counter::ONLINE_MINUTES, static_cast<uint64_t>(std::time(nullptr) - StartTime) / 60);
+    workload_.setTracked(state_.aircraftTracked);
+    bool onFireChanged = workload_.update(std::time(nullptr));
+    if (onFireChanged) {
+        recorder_.record(FlightRecorder::EventType::ON_FIRE_CHANGE, 0, workload_.isOnFire());
+        if (workload_.isOnFire()) updateBadge(BadgeEngine::Counter::ON_FIRE, ++onFireCount_);
+    }
+    state_.isOnFire = workload_.isOnFire();
+
+    bool changed = tracksChanged || onFireChanged || state_.connectionType != connectionBefore || state_.tier != tierBefore
+        || badgeUnlocked_ || movementRecorded_ || runwaysChanged;
+    badgeUnlocked_ = false;
+    movementRecorded_ = false;
+    dataInterval_.update(changed);
+    return changed;
 }
 
 void rpc::EuroscopeRPC::updateConnectionType()
 {
-	connectionType_ = State::IDLE;
+    int previous = state_.connectionType;
+	state_.connectionType = State::IDLE;
+    state_.facility = 0;
     CController selfController = myPluginInstance->ControllerMyself();
     int euroscopeConnectionType = myPluginInstance->GetConnectionType();
+    lastEuroscopeConnection_ = euroscopeConnectionType;
     switch (euroscopeConnectionType) {
     case CONNECTION_TYPE_NO:
-        connectionType_ = State::IDLE;
+        state_.connectionType = State::IDLE;
         break;
     case CONNECTION_TYPE_DIRECT:
         if (selfController.IsController()) {
-            connectionType_ = State::CONTROLLING;
+            state_.connectionType = State::CONTROLLING;
+            state_.facility = selfController.GetFacility();
             std::string freq = std::to_string(selfController.GetPrimaryFrequency());
-            currentFrequency_ = freq.substr(0, freq.length() - 3);
+            PluginState::copy(state_.frequency, freq.substr(0, freq.length() - 3));
+        }
+        else state_.connectionType = State::OBSERVING;
+        {
+            std::string callsign = selfController.GetCallsign();
+            std::transform(callsign.begin(), callsign.end(), callsign.begin(), ::toupper);
+            PluginState::copy(state_.callsign, callsign);
+            myAirport_ = airportOf(callsign);
         }
-        else connectionType_ = State::OBSERVING;
-        currentController_ = selfController.GetCallsign();
-		std::transform(currentController_.begin(), currentController_.end(), currentController_.begin(), ::toupper);
         break;
     case CONNECTION_TYPE_SWEATBOX:
-        connectionType_ = State::SWEATBOX;
+        state_.connectionType = State::SWEATBOX;
         break;
     case CONNECTION_TYPE_PLAYBACK:
-        connectionType_ = State::PLAYBACK;
+        state_.connectionType = State::PLAYBACK;
         break;
     default:
         DisplayMessage("Unknown connection type: " + std::to_string(euroscopeConnectionType), "Error");
-        connectionType_ = State::IDLE;
+        state_.connectionType = State::IDLE;
         break;
     }
+
+    if (state_.connectionType != previous) {
+        noteChange(ChangeCause::CONNECTION_CHANGE, FlightRecorder::now());
+        nextTrackReconcile_ = 0; // tracks held by this connection are walked on the next tick
+        if (state_.connectionType == State::IDLE) {
+            idleRotations_ = 0;
+            endAllTracks();
+            targetGrid_.reset(); // no position updates come while disconnected, the counts would stay
+        }
+        if (state_.connectionType == State::SWEATBOX) updateBadge(BadgeEngine::Counter::SWEATBOX_CONNECTIONS, ++sweatboxConnections_);
+        recorder_.record(FlightRecorder::EventType::STATE_CHANGE, static_cast<uint16_t>(previous), static_cast<uint32_t>(state_.connectionType));
+        session::Event event = sessionEvent(session::RecordType::CONNECTION_TYPE, "");
+        event.code = state_.connectionType;
+        session_.enqueue(event);
+    }
 }
 
-void rpc::EuroscopeRPC::getAicraftCount()
+// Walks every radar target, on the slow cadence only: picks up tracks started before the plugin was
+// loaded and drops those whose release no callback reported
+void rpc::EuroscopeRPC::reconcileTracks()
 {
-	totalAircrafts_ = 0;
-	aircraftTracked_ = 0;
     CRadarTarget target = myPluginInstance->RadarTargetSelectFirst();
-
     while (target.IsValid()) {
-		++totalAircrafts_;
-        if (target.GetCorrelatedFlightPlan().GetTrackingControllerIsMe()) {
-            ++aircraftTracked_;
-            if (trackedCallsigns_.insert(target.GetCallsign()).second) {
-                ++totalTracks_;
-            }
+        CFlightPlan flightPlan = target.GetCorrelatedFlightPlan();
+        PackedCallsign callsign = packCallsign(target.GetCallsign());
+        if (flightPlan.GetTrackingControllerIsMe()) trackStarted(flightPlan, callsign);
+        else {
+            recordControlTime(trackTimer_.stop(callsign, std::time(nullptr)));
+            sessionTracks_.release(callsign);
         }
         target = myPluginInstance->RadarTargetSelectNext(target);
-	}
+    }
+}
+
+// From the tracking callback, or the reconcile for tracks it has not reported (plugin loaded mid session)
+void rpc::EuroscopeRPC::trackStarted(CFlightPlan flightPlan, PackedCallsign callsign)
+{
+    int64_t now = std::time(nullptr);
+    trackTimer_.start(callsign, now);
+    SessionTracks::Join join = sessionTracks_.start(callsign);
+    if (join == SessionTracks::Join::FIRST) {
+        state_.totalTracks = static_cast<uint32_t>(sessionTracks_.size());
+        workload_.recordNewTrack();
+        updateBadge(BadgeEngine::Counter::SESSION_TRACKS, state_.totalTracks);
+    }
+    if (join != SessionTracks::Join::NONE && sessionList_.IsValid()) sessionList_.AddFpToTheList(flightPlan);
+}
+
+// Columns are only defined the first time, afterwards EuroScope restores them from the settings
+void rpc::EuroscopeRPC::registerSessionList()
+{
+    sessionList_ = RegisterFpList("My session tracks");
+    if (sessionList_.GetColumnNumber() > 0) return;
+    sessionList_.AddColumnDefinition("C/S", 10, false, nullptr, TAG_ITEM_TYPE_CALLSIGN, nullptr, TAG_ITEM_FUNCTION_NO, nullptr, TAG_ITEM_FUNCTION_NO);
+    sessionList_.AddColumnDefinition("TRK", 8, false, PLUGIN_NAME, TAG_ITEM_SESSION_TRACK_STATUS, nullptr, TAG_ITEM_FUNCTION_NO, nullptr, TAG_ITEM_FUNCTION_NO);
+    sessionList_.AddColumnDefinition("TIME", 6, true, PLUGIN_NAME, TAG_ITEM_TRACKING_DURATION, nullptr, TAG_ITEM_FUNCTION_NO, nullptr, TAG_ITEM_FUNCTION_NO);
+    sessionList_.AddColumnDefinition("ALT", 6, true, nullptr, TAG_ITEM_TYPE_ALTITUDE, nullptr, TAG_ITEM_FUNCTION_NO, nullptr, TAG_ITEM_FUNCTION_NO);
+    sessionList_.AddColumnDefinition("GND", 6, false, nullptr, TAG_ITEM_TYPE_GROUND_STATUS, nullptr, TAG_ITEM_FUNCTION_NO, nullptr, TAG_ITEM_FUNCTION_NO);
+    sessionList_.AddColumnDefinition("DEST", 5, false, nullptr, TAG_ITEM_TYPE_DESTINATION, nullptr, TAG_ITEM_FUNCTION_NO, nullptr, TAG_ITEM_FUNCTION_NO);
+}
+
+void EuroscopeRPC::OnFlightPlanControllerAssignedDataUpdate(CFlightPlan FlightPlan, int DataType)
+{
+    recorder_.countCallback(FlightRecorder::Callback::CONTROLLER_ASSIGNED_DATA);
+    if (!FlightPlan.IsValid()) return;
+
+    PackedCallsign target = packCallsign(FlightPlan.GetHandoffTargetControllerCallsign());
+    bool handoffTargetIsMe = target != INVALID_CALLSIGN && target == packCallsign(ControllerMyself().GetCallsign());
+    bool trackingIsMe = FlightPlan.GetTrackingControllerIsMe();
+    PackedCallsign callsign = packCallsign(FlightPlan.GetCallsign());
+
+    // The count itself is read in updateData, the latency starts here
+    if (trackingIsMe != handoffTracker_.isTrackedByMe(callsign) && trackChangeNs_ == 0) trackChangeNs_ = FlightRecorder::now();
+    if (trackingIsMe) trackStarted(FlightPlan, callsign);
+    else {
+        recordControlTime(trackTimer_.stop(callsign, std::time(nullptr)));
+        sessionTracks_.release(callsign);
+    }
+
+    if (uint32_t handoffs = handoffTracker_.update(callsign, trackingIsMe, target != INVALID_CALLSIGN, handoffTargetIsMe)) {
+        workload_.recordHandoff(handoffs);
+        int64_t now = std::time(nullptr);
+        handoffsHour_.record(now, handoffs);
+        updateBadge(BadgeEngine::Counter::HANDOFFS_PER_HOUR, handoffsHour_.total(now));
+    }
+
+    if (trackingIsMe && isInstruction(DataType)) workload_.recordInstruction();
+    if (DataType == CTR_DATA_TYPE_GROUND_STATE || DataType == CTR_DATA_TYPE_CLEARENCE_FLAG) updateMovements(FlightPlan);
+
+    if (session_.isRecording()) {
+        session::Event event = sessionEvent(session::RecordType::CONTROLLER_ASSIGNED, FlightPlan.GetCallsign());
+        event.code = DataType;
+        event.flags = (trackingIsMe ? session::TRACKING_IS_ME : 0) | (target != INVALID_CALLSIGN ? session::HANDOFF_PENDING : 0)
+            | (handoffTargetIsMe ? session::HANDOFF_TARGET_IS_ME : 0) | (isInstruction(DataType) ? session::IS_INSTRUCTION : 0);
+        session_.enqueue(event);
+    }
+}
+
+bool EuroscopeRPC::isInstruction(int dataType)
+{
+    switch (dataType) {
+    case CTR_DATA_TYPE_SQUAWK:
+    case CTR_DATA_TYPE_FINAL_ALTITUDE:
+    case CTR_DATA_TYPE_TEMPORARY_ALTITUDE:
+    case CTR_DATA_TYPE_GROUND_STATE:
+    case CTR_DATA_TYPE_CLEARENCE_FLAG:
+    case CTR_DATA_TYPE_SPEED:
+    case CTR_DATA_TYPE_MACH:
+    case CTR_DATA_TYPE_RATE:
+    case CTR_DATA_TYPE_HEADING:
+    case CTR_DATA_TYPE_DIRECT_TO:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void EuroscopeRPC::OnFlightPlanDisconnect(CFlightPlan FlightPlan)
+{
+    recorder_.countCallback(FlightRecorder::Callback::FLIGHT_PLAN_DISCONNECT);
+    PackedCallsign callsign = packCallsign(FlightPlan.GetCallsign());
+    handoffTracker_.remove(callsign);
+    sectorForecast_.remove(callsign);
+    targetGrid_.remove(callsign);
+    movements_.remove(callsign);
+    recordControlTime(trackTimer_.stop(callsign, std::time(nullptr)));
+    if (sessionTracks_.disconnect(callsign) && sessionList_.IsValid()) sessionList_.RemoveFpFromTheList(FlightPlan);
+    session_.enqueue(sessionEvent(session::RecordType::FLIGHT_PLAN_DISCONNECT, FlightPlan.GetCallsign()));
+}
+
+void EuroscopeRPC::OnFlightPlanFlightPlanDataUpdate(CFlightPlan FlightPlan)
+{
+    recorder_.countCallback(FlightRecorder::Callback::FLIGHT_PLAN_DATA);
+    updateForecast(FlightPlan);
+    if (FlightPlan.IsValid()) updateMovements(FlightPlan);
+}
+
+void EuroscopeRPC::OnRadarTargetPositionUpdate(CRadarTarget RadarTarget)
+{
+    recorder_.countCallback(FlightRecorder::Callback::RADAR_TARGET_POSITION);
+    if (!RadarTarget.IsValid()) return;
+
+    int64_t now = std::time(nullptr);
+    CPosition position = RadarTarget.GetPosition().GetPosition();
+    if (session_.isRecording()) {
+        session::Event event = sessionEvent(session::RecordType::RADAR_POSITION, RadarTarget.GetCallsign());
+        event.latitude = static_cast<int32_t>(std::lround(position.m_Latitude * session::COORDINATE_SCALE));
+        event.longitude = static_cast<int32_t>(std::lround(position.m_Longitude * session::COORDINATE_SCALE));
+        event.altitude = RadarTarget.GetPosition().GetPressureAltitude();
+        event.groundSpeed = RadarTarget.GetPosition().GetReportedGS();
+        session_.enqueue(event);
+    }
+
+    targetGrid_.update(packCallsign(RadarTarget.GetCallsign()), position.m_Latitude, position.m_Longitude, now);
+    if (uint32_t movements = movements_.updateGroundSpeed(packCallsign(RadarTarget.GetCallsign()), RadarTarget.GetPosition().GetReportedGS()))
+        recordMovements(RadarTarget.GetCorrelatedFlightPlan(), movements);
+    if (now - lastTargetExpiry_ >= TARGET_EXPIRY_INTERVAL) {
+        lastTargetExpiry_ = now;
+        targetGrid_.expire(now, TARGET_TIMEOUT);
+    }
+
+    updateForecast(RadarTarget.GetCorrelatedFlightPlan());
+}
+
+void EuroscopeRPC::OnControllerPositionUpdate(CController Controller)
+{
+    recorder_.countCallback(FlightRecorder::Callback::CONTROLLER_POSITION);
+    if (!Controller.IsValid()) return;
+
+    ControllerRegistry::Controller record;
+    record.callsign = packCallsign(Controller.GetCallsign());
+    record.facility = Controller.IsController() ? Controller.GetFacility() : 0;
+    record.rating = Controller.GetRating();
+    record.frequencyKhz = static_cast<int>(Controller.GetPrimaryFrequency() * 1000.0 + 0.5);
+    CPosition position = Controller.GetPosition();
+    record.latitude = position.m_Latitude;
+    record.longitude = position.m_Longitude;
+    controllerRegistry_.update(record);
+
+    CController self = ControllerMyself();
+    if (session_.isRecording()) {
+        session::Event event = sessionEvent(session::RecordType::CONTROLLER_POSITION, Controller.GetCallsign());
+        bool isSelf = self.IsValid() && record.callsign == packCallsign(self.GetCallsign());
+        event.flags = (isSelf ? session::IS_SELF : 0) | (Controller.IsController() ? session::IS_CONTROLLER : 0);
+        event.facility = Controller.GetFacility();
+        event.rating = record.rating;
+        event.frequencyKhz = record.frequencyKhz;
+        event.latitude = static_cast<int32_t>(std::lround(position.m_Latitude * session::COORDINATE_SCALE));
+        event.longitude = static_cast<int32_t>(std::lround(position.m_Longitude * session::COORDINATE_SCALE));
+        event.range = Controller.GetRange();
+        session_.enqueue(event);
+    }
+    if (self.IsValid()) {
+        // Observer to controller and back happens without a connection type change
+        bool direct = state_.connectionType == State::CONTROLLING || state_.connectionType == State::OBSERVING;
+        if (direct && record.callsign == packCallsign(self.GetCallsign()) && Controller.IsController() != (state_.connectionType == State::CONTROLLING))
+            selfRoleChanged_ = true;
+
+        CPosition selfPosition = self.GetPosition();
+        double range = self.GetRange() > 0 ? static_cast<double>(self.GetRange()) : NEARBY_ATC_RANGE;
+        controllerRegistry_.setReference(packCallsign(self.GetCallsign()), selfPosition.m_Latitude, selfPosition.m_Longitude, range);
+        if (self.GetRange() > 0) targetGrid_.setReference(selfPosition.m_Latitude, selfPosition.m_Longitude, range);
+    }
+}
+
+void EuroscopeRPC::OnControllerDisconnect(CController Controller)
+{
+    recorder_.countCallback(FlightRecorder::Callback::CONTROLLER_DISCONNECT);
+    controllerRegistry_.remove(packCallsign(Controller.GetCallsign()));
+    session_.enqueue(sessionEvent(session::RecordType::CONTROLLER_DISCONNECT, Controller.GetCallsign()));
+}
+
+// Voice callbacks run on EuroScope's audio thread, VoiceStats is lock free
+void EuroscopeRPC::OnVoiceTransmitStarted(bool OnPrimary)
+{
+    recorder_.countCallback(FlightRecorder::Callback::VOICE_TRANSMIT);
+    voiceStats_.transmitStarted();
+}
+
+void EuroscopeRPC::OnVoiceTransmitEnded(bool OnPrimary)
+{
+    voiceStats_.transmitEnded();
+}
+
+void EuroscopeRPC::OnVoiceReceiveStarted(CGrountToAirChannel Channel)
+{
+    recorder_.countCallback(FlightRecorder::Callback::VOICE_RECEIVE);
+    voiceStats_.receiveStarted();
+}
+
+void EuroscopeRPC::OnCompileFrequencyChat(const char* sSenderCallsign, double Frequency, const char* sChatMessage)
+{
+    recorder_.countCallback(FlightRecorder::Callback::FREQUENCY_CHAT);
+    uint64_t before = commsStats_.getTotalMessages();
+    commsStats_.recordFrequencyMessage(sSenderCallsign, sChatMessage, std::time(nullptr));
+    if (commsStats_.getTotalMessages() != before) workload_.recordMessage();
+}
+
+void EuroscopeRPC::OnCompilePrivateChat(const char* sSenderCallsign, const char* sReceiverCallsign, const char* sChatMessage)
+{
+    recorder_.countCallback(FlightRecorder::Callback::PRIVATE_CHAT);
+    commsStats_.recordPrivateMessage(sSenderCallsign, sChatMessage, std::time(nullptr));
+    workload_.recordMessage();
+}
+
+void EuroscopeRPC::OnNewMetarReceived(const char* sStation, const char* sFullMetar)
+{
+    recorder_.countCallback(FlightRecorder::Callback::METAR);
+    if (sStation == nullptr || sFullMetar == nullptr) return;
+    metarCache_.update(sStation, sFullMetar, std::time(nullptr));
+}
+
+bool EuroscopeRPC::OnCompileCommand(const char* sCommandLine)
+{
+    recorder_.countCallback(FlightRecorder::Callback::COMMAND);
+    std::string command = sCommandLine ? sCommandLine : "";
+    std::transform(command.begin(), command.end(), command.begin(), ::tolower);
+    if (command.rfind(".rpc", 0) != 0 || (command.size() > 4 && command[4] != ' ')) return false;
+
+    size_t start = command.find_first_not_of(' ', 4);
+    std::string argument = start == std::string::npos ? "" : command.substr(start, command.find_last_not_of(' ') + 1 - start);
+    if (argument == "dump") {
+        dumpRecorder("EuroscopeRPC-" + std::to_string(std::time(nullptr)) + ".blackbox");
+        return true;
+    }
+    if (argument.rfind("record", 0) == 0) {
+        recordSession(argument.size() > 7 ? argument.substr(7) : "");
+        return true;
+    }
+    if (argument.rfind("latency", 0) == 0) {
+        reportLatency(argument.size() > 8 ? argument.substr(8) : "");
+        return true;
+    }
+    if (argument == "cadence") {
+        reportCadence();
+        return true;
+    }
+    if (argument == "control") {
+        reportControlTimes();
+        return true;
+    }
+    if (argument == "badges") {
+        reportBadges();
+        return true;
+    }
+    if (argument == "runways") {
+        reportRunways();
+        return true;
+    }
+    if (argument == "radio") {
+        reportRadio();
+        return true;
+    }
+    if (argument == "chat") {
+        reportChat();
+        return true;
+    }
+
+    DisplayMessage("Usage: .rpc dump | .rpc record [start|stop] | .rpc latency [export|reset] | .rpc cadence | .rpc control | .rpc badges | .rpc runways | .rpc radio | .rpc chat", "Commands");
+    return true;
+}
+
+// Called for every tag of every target on each scope refresh: one probe, the text is cached
+void EuroscopeRPC::OnGetTagItem(CFlightPlan FlightPlan, CRadarTarget RadarTarget, int ItemCode, int TagData, char sItemString[16], int* pColorCode, COLORREF* pRGB, double* pFontSize)
+{
+    recorder_.countCallback(FlightRecorder::Callback::TAG_ITEM);
+    if (!FlightPlan.IsValid()) return;
+    if (ItemCode == TAG_ITEM_TRACKING_DURATION) {
+        if (const char* text = trackTimer_.text(packCallsign(FlightPlan.GetCallsign()), tagNow_))
+            std::memcpy(sItemString, text, TrackTimer::TEXT_SIZE);
+    }
+    else if (ItemCode == TAG_ITEM_SESSION_TRACK_STATUS) {
+        if (const SessionTracks::Entry* entry = sessionTracks_.find(packCallsign(FlightPlan.GetCallsign())))
+            std::strcpy(sItemString, SessionTracks::statusText(entry->status));
+    }
+}
+
+void EuroscopeRPC::OnAirportRunwayActivityChanged()
+{
+    recorder_.countCallback(FlightRecorder::Callback::RUNWAY_ACTIVITY);
+    rebuildRunways();
+}
+
+// Walks every runway element of the sector file, thousands on large ones: done when the activity
+// changes, never per tick. The next poll publishes the runways of my airport.
+void EuroscopeRPC::rebuildRunways()
+{
+    uint64_t start = FlightRecorder::now();
+    runways_.clear();
+    runwayElements_ = 0;
+    for (CSectorElement runway = SectorFileElementSelectFirst(SECTOR_ELEMENT_RUNWAY); runway.IsValid();
+        runway = SectorFileElementSelectNext(runway, SECTOR_ELEMENT_RUNWAY)) {
+        ++runwayElements_;
+        for (int end = 0; end < 2; ++end) {
+            if (runway.IsElementActive(true, end) || runway.IsElementActive(false, end))
+                runways_.add(runway.GetAirportName(), runway.GetRunwayName(end));
+        }
+    }
+    runwayRebuildUs_.record((FlightRecorder::now() - start) / 1000);
+}
+
+void EuroscopeRPC::reportRunways()
+{
+    DisplayMessage(std::to_string(runways_.size()) + " airports with active runways from " + std::to_string(runwayElements_) + " runway elements", "Runways");
+    DisplayMessage(std::to_string(runwayRebuildUs_.getCount()) + " rebuilds, p50 " + std::to_string(runwayRebuildUs_.percentile(0.5))
+        + " us, max " + std::to_string(runwayRebuildUs_.getMax()) + " us", "Runways");
+    const char* runways = myAirport_.empty() ? nullptr : runways_.find(myAirport_);
+    if (runways) DisplayMessage(myAirport_ + " " + runways, "Runways");
+}
+
+// Voice session summary: the transmission counts, airtime and the length histogram
+void EuroscopeRPC::reportRadio()
+{
+    static constexpr const char* LENGTHS[VoiceStats::HISTOGRAM_BUCKETS] = { "<0.5s", "<1s", "<2s", "<4s", "<8s", "<16s", "<32s", "32s+" };
+    VoiceStats::Summary voice = voiceStats_.getSummary();
+    DisplayMessage(std::to_string(voice.transmissions) + " transmissions, " + ControlTimeStats::formatDuration(voice.airtimeMs / 1000)
+        + " airtime, " + std::to_string(voice.receptions) + " receptions", "Radio");
+    if (voice.transmissions == 0) return;
+    std::string lengths;
+    for (size_t i = 0; i < VoiceStats::HISTOGRAM_BUCKETS; ++i) {
+        if (voice.lengths[i] == 0) continue;
+        if (!lengths.empty()) lengths += ", ";
+        lengths += std::string(LENGTHS[i]) + " " + std::to_string(voice.lengths[i]);
+    }
+    DisplayMessage("Transmission lengths: " + lengths, "Radio");
+}
+
+// Text message rates over the last minute and the busiest senders, counts are upper bounds
+void EuroscopeRPC::reportChat()
+{
+    int64_t now = std::time(nullptr);
+    char rates[96];
+    std::snprintf(rates, sizeof(rates), "%.1f frequency and %.1f private messages per minute, %llu in total",
+        commsStats_.frequencyPerMinute(now), commsStats_.privatePerMinute(now), static_cast<unsigned long long>(commsStats_.getTotalMessages()));
+    DisplayMessage(rates, "Chat");
+
+    std::string senders;
+    for (const CommsStats::Sender& sender : commsStats_.topSenders()) {
+        if (sender.count == 0) break;
+        char callsign[PACKED_CALLSIGN_LENGTH + 1];
+        if (unpackCallsign(sender.callsign, callsign) == 0) std::strcpy(callsign, "?"); // too long to pack, only hashed
+        if (!senders.empty()) senders += ", ";
+        senders += std::string(callsign) + " " + std::to_string(sender.count);
+    }
+    if (!senders.empty()) DisplayMessage("Busiest senders: " + senders, "Chat");
+}
+
+// Directory holding the plugin DLL, with a trailing separator
+std::string EuroscopeRPC::pluginDirectory()
+{
+    HMODULE module = nullptr;
+    char path[MAX_PATH] = {};
+    if (!GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+        reinterpret_cast<LPCSTR>(&EuroscopeRPC::pluginDirectory), &module)) return "";
+    if (GetModuleFileNameA(module, path, MAX_PATH) == 0) return "";
+
+    std::string directory = path;
+    size_t separator = directory.find_last_of(DIR_SEPARATOR);
+    return separator == std::string::npos ? "" : directory.substr(0, separator + 1);
+}
+
+void EuroscopeRPC::dumpRecorder(const std::string& fileName)
+{
+    std::string path = pluginDirectory() + fileName;
+    size_t events = recorder_.snapshot().size();
+    if (recorder_.dump(path)) DisplayMessage("Flight recorder written to " + path + " (" + std::to_string(events) + " events)", "Status");
+    else DisplayMessage("Failed to write flight recorder to " + path, "Error");
+}
+
+void EuroscopeRPC::recordSession(const std::string& argument)
+{
+    if (argument == "start") {
+        std::string path = pluginDirectory() + "EuroscopeRPC-" + std::to_string(std::time(nullptr)) + ".session";
+        session::Event initial = sessionEvent(session::RecordType::CONNECTION_TYPE, "");
+        if (!session_.start(path, initial.timeMs)) {
+            DisplayMessage(session_.isRecording() ? "Session recording already running" : "Failed to create " + path, "Error");
+            return;
+        }
+        initial.code = state_.connectionType;
+        session_.enqueue(initial);
+        DisplayMessage("Recording session to " + path, "Status");
+    }
+    else if (argument == "stop" && session_.isRecording()) {
+        session_.stop();
+        DisplayMessage("Session recording stopped", "Status");
+    }
+
+    if (argument != "start")
+        DisplayMessage(std::string(session_.isRecording() ? "Recording" : "Not recording") + ", " + std::to_string(session_.getRecorded()) + " events, "
+            + std::to_string(session_.getBytesWritten() / 1024) + " KB, " + std::to_string(session_.getDropped()) + " dropped", "Status");
+}
+
+// Stamps the published state with the event that made the presence stale. While the previous
+// change has not reached the presence thread its older stamp is kept, so the sample covers the
+// whole wait rather than only the last event.
+void EuroscopeRPC::noteChange(ChangeCause cause, uint64_t whenNs)
+{
+    if (state_.changeSequence != writtenChange_.load(std::memory_order_relaxed)) return;
+    state_.changeCause = static_cast<int32_t>(cause);
+    state_.changedNs = whenNs;
+    ++state_.changeSequence;
+}
+
+// Presence thread: the first frame carrying a change closes its sample. Frames that are not sent
+// still acknowledge it, time spent suppressed or as a follower is not latency.
+void EuroscopeRPC::acknowledgeChange(const PluginState& state, bool sent)
+{
+    if (state.changeSequence == writtenChange_.load(std::memory_order_relaxed)) return;
+    if (sent && state.changeCause >= 0 && state.changeCause < static_cast<int32_t>(ChangeCause::COUNT)) {
+        uint64_t now = FlightRecorder::now();
+        latency_[state.changeCause].record(now > state.changedNs ? (now - state.changedNs) / 1000 : 0);
+    }
+    writtenChange_.store(state.changeSequence, std::memory_order_relaxed);
+}
+
+const char* EuroscopeRPC::causeName(ChangeCause cause)
+{
+    switch (cause) {
+    case ChangeCause::TRACK_CHANGE: return "track change";
+    case ChangeCause::CONNECTION_CHANGE: return "connection change";
+    case ChangeCause::IDLE_ROTATION: return "idle rotation";
+    default: return "unknown";
+    }
+}
+
+void EuroscopeRPC::reportLatency(const std::string& argument)
+{
+    if (argument == "export") {
+        exportLatency();
+        return;
+    }
+    if (argument == "reset") {
+        for (LatencyHistogram& histogram : latency_) histogram.reset();
+        DisplayMessage("Latency histograms cleared", "Latency");
+        return;
+    }
+
+    for (size_t cause = 0; cause < latency_.size(); ++cause) {
+        const LatencyHistogram& histogram = latency_[cause];
+        char line[160];
+        if (histogram.getCount() == 0)
+            std::snprintf(line, sizeof(line), "%s: no samples", causeName(static_cast<ChangeCause>(cause)));
+        else
+            std::snprintf(line, sizeof(line), "%s: %llu samples, p50 %.0f ms, p90 %.0f ms, p99 %.0f ms, max %.0f ms",
+                causeName(static_cast<ChangeCause>(cause)), static_cast<unsigned long long>(histogram.getCount()),
+                histogram.percentile(0.5) / 1000.0, histogram.percentile(0.9) / 1000.0, histogram.percentile(0.99) / 1000.0, histogram.getMax() / 1000.0);
+        DisplayMessage(line, "Latency");
+    }
+}
+
+// One row per non empty bucket, bounds in microseconds
+void EuroscopeRPC::exportLatency()
+{
+    std::string path = pluginDirectory() + "EuroscopeRPC-latency-" + std::to_string(std::time(nullptr)) + ".csv";
+    FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) {
+        DisplayMessage("Failed to write latency histograms to " + path, "Error");
+        return;
+    }
+    std::fprintf(file, "cause,lower_us,upper_us,count\n");
+    for (size_t cause = 0; cause < latency_.size(); ++cause) {
+        for (size_t bucket = 0; bucket < LatencyHistogram::BUCKETS; ++bucket) {
+            uint64_t count = latency_[cause].getBucketCount(bucket);
+            if (count == 0) continue;
+            std::fprintf(file, "%s,%llu,%llu,%llu\n", causeName(static_cast<ChangeCause>(cause)),
+                static_cast<unsigned long long>(LatencyHistogram::lowerBound(bucket)),
+                static_cast<unsigned long long>(LatencyHistogram::upperBound(bucket)), static_cast<unsigned long long>(count));
+        }
+    }
+    std::fclose(file);
+    DisplayMessage("Latency histograms written to " + path, "Latency");
+}
+
+void EuroscopeRPC::reportCadence()
+{
+    int64_t wait = presenceWaitMs_.load(std::memory_order_relaxed);
+    DisplayMessage("Presence thread: " + std::to_string(presenceWakeups_.total(std::time(nullptr)))
+        + " wakeups in the last minute, " + std::to_string(totalWakeups_.load(std::memory_order_relaxed)) + " total, "
+        + (wait < 0 ? std::string("parked") : "next in " + std::to_string(wait / 1000) + " s"), "Cadence");
+    DisplayMessage("SDK poll every " + std::to_string(dataInterval_.get()) + " s", "Cadence");
+}
+
+// Tracking intervals count for the position I was on when they ended, -1 is no interval
+void EuroscopeRPC::recordControlTime(int64_t seconds)
+{
+    if (seconds >= 0) controlTimes_.record(state_.callsign, static_cast<uint64_t>(seconds));
+}
+
+// Disconnected or unloading, what is still tracked stops being under my control now
+void EuroscopeRPC::endAllTracks()
+{
+    trackTimer_.stopAll(std::time(nullptr), [this](int64_t seconds) { recordControlTime(seconds); });
+    sessionTracks_.releaseAll();
+}
+
+void EuroscopeRPC::reportControlTimes()
+{
+    auto line = [](const LatencyHistogram& histogram) {
+        return std::to_string(histogram.getCount()) + " aircraft, p50 " + ControlTimeStats::formatDuration(histogram.percentile(0.5))
+            + ", p90 " + ControlTimeStats::formatDuration(histogram.percentile(0.9)) + ", max " + ControlTimeStats::formatDuration(histogram.getMax());
+    };
+    DisplayMessage("Session: " + line(controlTimes_.getSession()), "Control");
+    for (const auto& [position, histogram] : controlTimes_.getSessionPositions())
+        DisplayMessage(position + ": " + line(histogram), "Control");
+    if (state_.callsign[0] == '\0') return;
+    LatencyHistogram allTime;
+    controlTimes_.allTime(state_.callsign, allTime);
+    DisplayMessage(std::string(state_.callsign) + " all sessions: " + line(allTime), "Control");
+}
+
+// Rules from the file beside the DLL when there is one, the built in ones otherwise
+void EuroscopeRPC::loadBadges()
+{
+    std::string error;
+    std::ifstream file(pluginDirectory() + BADGE_RULES_FILE);
+    if (file) {
+        std::string rules((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (!badges_.compile(rules, error)) DisplayMessage(std::string(BADGE_RULES_FILE) + " " + error + ", using the default badges", "Error");
+    }
+    if (!file || !error.empty()) badges_.compile(BadgeEngine::DEFAULT_RULES, error);
+    badges_.loadUnlocked(pluginDirectory() + BADGE_UNLOCKS_FILE);
+}
+
+// Only the rules reading this counter are looked at, unlocks are rare enough to save each one
+void EuroscopeRPC::updateBadge(BadgeEngine::Counter counter, uint64_t value)
+{
+    bool unlocked = false;
+    badges_.update(counter, value, std::time(nullptr), [&](const BadgeEngine::Badge& badge) {
+        PluginState::copy(state_.badge, badge.title);
+        DisplayMessage("Badge unlocked: " + badge.title, "Badges");
+        unlocked = true;
+    });
+    if (!unlocked) return;
+    badgeUnlocked_ = true;
+    if (!badges_.saveUnlocked(pluginDirectory() + BADGE_UNLOCKS_FILE))
+        DisplayMessage("Failed to save unlocked badges", "Error");
+}
+
+void EuroscopeRPC::reportBadges()
+{
+    for (const BadgeEngine::Badge& badge : badges_.getBadges()) {
+        std::string status;
+        if (badge.unlockedAt) {
+            char date[16] = {};
+            std::tm local = {};
+            std::time_t when = static_cast<std::time_t>(badge.unlockedAt);
+            localtime_s(&local, &when);
+            std::strftime(date, sizeof(date), "%Y-%m-%d", &local);
+            status = std::string("unlocked ") + date;
+        }
+        else status = std::to_string(badges_.getValue(badge.counter)) + "/" + std::to_string(badge.threshold) + " " + BadgeEngine::counterName(badge.counter);
+        DisplayMessage(badge.title + ": " + status, "Badges");
+    }
+}
+
+// Ground state and clearance flag changes, from either flight plan callback
+void EuroscopeRPC::updateMovements(const CFlightPlan& flightPlan)
+{
+    uint32_t movements = movements_.updateFlightPlan(packCallsign(flightPlan.GetCallsign()),
+        MovementCounters::parseGroundState(flightPlan.GetGroundState()), flightPlan.GetClearenceFlag());
+    if (movements) recordMovements(flightPlan, movements);
+}
+
+// Departure movements count at the origin, arrival ones at the destination
+void EuroscopeRPC::recordMovements(const CFlightPlan& flightPlan, uint32_t movements)
+{
+    if (myAirport_.empty() || !flightPlan.IsValid()) return;
+    const CFlightPlanData data = flightPlan.GetFlightPlanData();
+    uint32_t mine = (myAirport_ == data.GetOrigin() ? MovementCounters::DEPARTURE_MOVEMENTS : 0)
+        | (myAirport_ == data.GetDestination() ? MovementCounters::ARRIVAL_MOVEMENTS : 0);
+    if (!(movements & mine)) return;
+    movements_.record(movements & mine, std::time(nullptr));
+    movementRecorded_ = true;
+}
+
+void EuroscopeRPC::updateForecast(const CFlightPlan& flightPlan)
+{
+    if (!flightPlan.IsValid()) return;
+    sectorForecast_.update(packCallsign(flightPlan.GetCallsign()), flightPlan.GetSectorEntryMinutes(),
+        flightPlan.GetSectorExitMinutes(), std::time(nullptr) / 60);
+
+    if (session_.isRecording()) {
+        session::Event event = sessionEvent(session::RecordType::FLIGHT_PLAN_DATA, flightPlan.GetCallsign());
+        event.entryMinutes = flightPlan.GetSectorEntryMinutes();
+        event.exitMinutes = flightPlan.GetSectorExitMinutes();
+        session_.enqueue(event);
+    }
+}
+
+session::Event EuroscopeRPC::sessionEvent(session::RecordType type, const char* callsign)
+{
+    session::Event event;
+    event.timeMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    event.type = type;
+    PluginState::copy(event.callsign, callsign ? callsign : "");
+    return event;
+}
+
+uint32_t EuroscopeRPC::aircraftInRange(uint32_t totalAircrafts) const
+{
+    // Falls back to every known target until my own position and range are known
+    return targetGrid_.hasReference() ? targetGrid_.getInRangeCount() : totalAircrafts;
 }
 
 void EuroscopeRPC::runUpdate() {
+    if (!sharedPresence_.isLeader()) {
+        recorder_.record(FlightRecorder::EventType::PRESENCE_SUPPRESSED, static_cast<uint16_t>(FlightRecorder::SuppressReason::NOT_LEADER));
+        acknowledgeChange(sharedState_.load(), false);
+        presenceSettled_ = true;
+        return;
+    }
 	this->updatePresence();
 }
 
+InstanceSnapshot EuroscopeRPC::buildInstanceSnapshot(const PluginState& state)
+{
+    InstanceSnapshot snapshot;
+    snapshot.state = state.connectionType;
+    snapshot.controlling = state.connectionType == State::CONTROLLING;
+    snapshot.tracked = state.aircraftTracked;
+    snapshot.total = state.totalAircrafts;
+    std::memcpy(snapshot.callsign, state.callsign, sizeof(snapshot.callsign));
+    std::memcpy(snapshot.frequency, state.frequency, sizeof(snapshot.frequency));
+    return snapshot;
+}
+
+// Called by EuroScope on its own thread: the only place the SDK is polled and the state written
 void EuroscopeRPC::OnTimer(int Counter) {
-    if (Counter % 5 == 0) // Every 5 seconds
-        updateData();
-    if (Counter % 15 == 0) // Every 15 seconds
+    recorder_.countCallback(FlightRecorder::Callback::TIMER);
+    uint64_t now = FlightRecorder::now();
+    if (int64_t late = (lastTimerNs_ ? static_cast<int64_t>(now - lastTimerNs_) / 1000000 : 0) - 1000; late > SCHEDULER_OVERRUN_MS)
+        recorder_.record(FlightRecorder::EventType::SCHEDULER_OVERRUN, static_cast<uint16_t>(FlightRecorder::Scheduler::EUROSCOPE_TIMER), static_cast<uint32_t>(late));
+    lastTimerNs_ = now;
+    tagNow_ = std::time(nullptr);
+    recorder_.flushCallbacks();
+    flushMessages();
+
+    // Transitions are refreshed on the tick they are seen, everything else as often as it changes
+    bool transition = detectTransition();
+    bool changed = false;
+    if (Counter >= nextTrackReconcile_ && state_.connectionType != State::IDLE) {
+        reconcileTracks();
+        nextTrackReconcile_ = Counter + TRACK_RECONCILE_INTERVAL;
+    }
+    if (Counter >= nextDataRefresh_ || transition) {
+        changed = updateData();
+        nextDataRefresh_ = Counter + static_cast<int>(dataInterval_.get());
+    }
+    // The idle text only shows while disconnected, and stops rotating after a while so the
+    // presence thread can park
+    if (Counter % 15 == 0 && state_.connectionType == State::IDLE && idleRotations_ < IDLE_TEXT_ROTATIONS) {
         changeIdlingText();
-    this->runUpdate();
+        ++idleRotations_;
+        changed = true;
+    }
+    sharedState_.store(state_);
+
+    // The heartbeat lives here so the presence thread can park: an instance joining or leaving
+    // wakes it to merge or take over
+    uint32_t instances = sharedPresence_.heartbeat();
+    bool companyChanged = sharedInstances_.exchange(instances, std::memory_order_relaxed) != instances;
+    if (transition || changed || companyChanged) wakePresence();
+}
+
+// Cheap enough for every tick: one SDK call for the connection type, flags left by the callbacks
+// for tracking and role changes
+bool EuroscopeRPC::detectTransition()
+{
+    bool transition = GetConnectionType() != lastEuroscopeConnection_ || selfRoleChanged_ || trackChangeNs_ != 0;
+    selfRoleChanged_ = false;
+    return transition;
+}
+
+void EuroscopeRPC::wakePresence()
+{
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+        wakeRequested_ = true;
+    }
+    wake_.notify_one();
+}
+
+// Sleep of the presence thread, cut short by wakePresence, forever when the timeout is negative.
+// True when woken early.
+bool EuroscopeRPC::waitForTick(int64_t timeoutMs)
+{
+    std::unique_lock<std::mutex> lock(wakeMutex_);
+    bool woken = true;
+    if (timeoutMs < 0) wake_.wait(lock, [this] { return wakeRequested_; });
+    else woken = wake_.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this] { return wakeRequested_; });
+    wakeRequested_ = false;
+    return woken;
 }
 
 void EuroscopeRPC::run() {
     int counter = 1;
     discordSetup();
-    discord::RPCManager::get().initialize();
-    auto& rpc = discord::RPCManager::get();
+    bool discordConnected = false;
+    uint64_t lastTick = FlightRecorder::now();
+    int64_t waitMs = PRESENCE_INTERVAL_MIN_MS;
 
     while (true) {
         counter += 1;
-        std::this_thread::sleep_for(std::chrono::seconds(1));
+        bool woken = waitForTick(waitMs);
+        presenceWakeups_.record(std::time(nullptr));
+        totalWakeups_.fetch_add(1, std::memory_order_relaxed);
+
+        uint64_t now = FlightRecorder::now();
+        if (int64_t late = static_cast<int64_t>(now - lastTick) / 1000000 - waitMs; !woken && late > SCHEDULER_OVERRUN_MS)
+            recorder_.record(FlightRecorder::EventType::SCHEDULER_OVERRUN, static_cast<uint16_t>(FlightRecorder::Scheduler::PRESENCE_THREAD), static_cast<uint32_t>(late));
+        lastTick = now;
 
         if (true == this->m_stop) {
-            discord::RPCManager::get().shutdown();
+            if (discordConnected) discord::RPCManager::get().shutdown();
             return;
         }
-        
-        this->OnTimer(counter);
+
+        // Only the leader instance keeps a Discord connection, the others just publish their snapshot
+        bool leader = sharedPresence_.tick(buildInstanceSnapshot(sharedState_.load()));
+        if (leader != discordConnected)
+            recorder_.record(FlightRecorder::EventType::LEADER_CHANGE, 0, leader);
+        if (leader && !discordConnected) {
+            discord::RPCManager::get().initialize();
+            discordConnected = true;
+        }
+        else if (!leader && discordConnected) {
+            discord::RPCManager::get().clearPresence();
+            discord::RPCManager::get().shutdown();
+            discordConnected = false;
+        }
+
+        this->runUpdate();
+
+        // Back off while nothing changes and park while disconnected with a settled presence
+        waitMs = presenceCadence_.next(presenceSettled_, woken, sharedState_.load().connectionType == State::IDLE,
+            sharedInstances_.load(std::memory_order_relaxed));
+        presenceWaitMs_.store(waitMs, std::memory_order_relaxed);
     }
     return;
 }
\ No newline at end of file
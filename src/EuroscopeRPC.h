@@ -1,36 +1,63 @@
 #pragma once
+#include <array>
+#include <atomic>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 #include <thread>
 #include <vector>
-#include <unordered_set>
 #define WIN32_LEAN_AND_MEAN
 #include <Windows.h>
 #include <EuroScopePlugIn.h>
 #include <discord-rpc.hpp>
 
-using namespace EuroScopePlugIn;
-
-enum State {
-    IDLE = 0,
-	CONTROLLING,
-	OBSERVING,
-    SWEATBOX,
-    PLAYBACK
-};
+#include "AdaptiveInterval.h"
+#include "BadgeEngine.h"
+#include "CommsStats.h"
+#include "ControllerRegistry.h"
+#include "ControlTimeStats.h"
+#include "FlightRecorder.h"
+#include "HandoffTracker.h"
+#include "LatencyHistogram.h"
+#include "MessageQueue.h"
+#include "MetarCache.h"
+#include "MovementCounters.h"
+#include "PluginState.h"
+#include "PluginTuning.h"
+#include "Presence.h"
+#include "PresenceCadence.h"
+#include "RateCounter.h"
+#include "RunwayCache.h"
+#include "SectorForecast.h"
+#include "SessionRecorder.h"
+#include "SessionTracks.h"
+#include "Seqlock.h"
+#include "SharedPresence.h"
+#include "SlidingWindowLimit.h"
+#include "TargetGrid.h"
+#include "TrackTimer.h"
+#include "VoiceStats.h"
+#include "WorkloadEstimator.h"
 
-enum Tier {
-    NONE = 0,
-    SILVER,
-    GOLD
-};
+using namespace EuroScopePlugIn;
 
 namespace rpc {
     constexpr auto APPLICATION_ID = "1408567135428673546";
+    constexpr auto PLUGIN_NAME = "EuroscopeRPC";
     static int64_t StartTime;
     static bool SendPresence = true;
 
-	constexpr uint32_t ONFIRE_THRESHOLD = 10;
-	constexpr uint32_t HOUR_THRESHOLD = 7200; // 2 hour
+	constexpr int64_t SCHEDULER_OVERRUN_MS = 500; // lateness of a one second tick worth recording
+	constexpr int64_t MESSAGE_DEDUPE_SECONDS = 30; // identical chat messages shown once per window
+	constexpr uint32_t MESSAGE_BURST = 5;
+	constexpr int64_t MESSAGE_REFILL_SECONDS = 2;
+	constexpr int TRACK_RECONCILE_INTERVAL = 60; // seconds between radar target walks catching tracks the callbacks missed
+	constexpr int IDLE_TEXT_ROTATIONS = 8; // idle texts shown per disconnected period, 15 seconds each
+	constexpr int TAG_ITEM_TRACKING_DURATION = 1;
+	constexpr int TAG_ITEM_SESSION_TRACK_STATUS = 2;
+	constexpr auto CONTROL_TIMES_FILE = "EuroscopeRPC-control-times.bin"; // beside the DLL
+	constexpr auto BADGE_RULES_FILE = "EuroscopeRPC-badges.txt"; // optional, replaces the default rules
+	constexpr auto BADGE_UNLOCKS_FILE = "EuroscopeRPC-badges.unlocked";
 
     class EuroscopeRPCCommandProvider;
 
@@ -45,50 +72,148 @@ namespace rpc {
 		void Shutdown();
         void Reset();
 
-        // Radar commands
+        // Radar commands, safe from any thread: messages are queued and shown on the next OnTimer
         void DisplayMessage(const std::string& message, const std::string& sender = "");
 		
         // Scope events
         void OnTimer(int Counter);
+        void OnFlightPlanControllerAssignedDataUpdate(CFlightPlan FlightPlan, int DataType);
+        void OnFlightPlanDisconnect(CFlightPlan FlightPlan);
+        void OnFlightPlanFlightPlanDataUpdate(CFlightPlan FlightPlan);
+        void OnRadarTargetPositionUpdate(CRadarTarget RadarTarget);
+        void OnControllerPositionUpdate(CController Controller);
+        void OnControllerDisconnect(CController Controller);
+        void OnVoiceTransmitStarted(bool OnPrimary);
+        void OnVoiceTransmitEnded(bool OnPrimary);
+        void OnVoiceReceiveStarted(CGrountToAirChannel Channel);
+        void OnCompileFrequencyChat(const char* sSenderCallsign, double Frequency, const char* sChatMessage);
+        void OnCompilePrivateChat(const char* sSenderCallsign, const char* sReceiverCallsign, const char* sChatMessage);
+        void OnNewMetarReceived(const char* sStation, const char* sFullMetar);
+        bool OnCompileCommand(const char* sCommandLine);
+        void OnGetTagItem(CFlightPlan FlightPlan, CRadarTarget RadarTarget, int ItemCode, int TagData, char sItemString[16], int* pColorCode, COLORREF* pRGB, double* pFontSize);
+        void OnAirportRunwayActivityChanged();
 
         // Getters
 		bool getPresence() const { return m_presence; }
 
 		// Setters
-		void setPresence(bool presence) { m_presence = presence; }
+		void setPresence(bool presence) { m_presence = presence; wakePresence(); }
 
     private:
         void discordSetup();
         void changeIdlingText();
 		void updatePresence();
-		void updateData();
+		bool updateData();
 		void updateConnectionType();
-        void getAicraftCount();
+        void reconcileTracks();
+        void trackStarted(CFlightPlan flightPlan, PackedCallsign callsign);
+        void registerSessionList();
+        void updateForecast(const CFlightPlan& flightPlan);
+        uint32_t aircraftInRange(uint32_t totalAircrafts) const;
+        static InstanceSnapshot buildInstanceSnapshot(const PluginState& state);
+        static bool isInstruction(int dataType);
+        static std::string airportOf(const std::string& callsign);
+        static std::string pluginDirectory();
+        void dumpRecorder(const std::string& fileName);
+        void flushMessages();
+        static session::Event sessionEvent(session::RecordType type, const char* callsign);
+        void recordSession(const std::string& argument);
+        void noteChange(ChangeCause cause, uint64_t whenNs);
+        void acknowledgeChange(const PluginState& state, bool sent);
+        void reportLatency(const std::string& argument);
+        void exportLatency();
+        static const char* causeName(ChangeCause cause);
+        bool detectTransition();
+        void wakePresence();
+        bool waitForTick(int64_t timeoutMs);
+        void reportCadence();
+        void recordControlTime(int64_t seconds);
+        void endAllTracks();
+        void reportControlTimes();
+        void loadBadges();
+        void updateBadge(BadgeEngine::Counter counter, uint64_t value);
+        void reportBadges();
+        void updateMovements(const CFlightPlan& flightPlan);
+        void recordMovements(const CFlightPlan& flightPlan, uint32_t movements);
+        void rebuildRunways();
+        void reportRunways();
+        void reportRadio();
+        void reportChat();
         void runUpdate();
         void run();
 
     private:
         // Plugin state
         bool initialized_ = false;
-		bool m_stop;
-		bool m_presence = true; // Send presence to Discord
+		std::atomic<bool> m_stop;
+		std::atomic<bool> m_presence = true; // Send presence to Discord
 		std::thread m_thread;
 
-		int connectionType_ = State::IDLE;
-
-		int tier_ = Tier::NONE;
-        bool isOnFire_ = false;
-		bool isSilver_ = false;
-        bool isGolden_ = false;
-        std::string currentController_ = "";
-        std::string currentFrequency_ = "";
-		std::string idlingText_ = "Watching the skies";
-		int onlineTime_ = 0; // in hours
-		std::unordered_set<std::string> trackedCallsigns_;
-        
-		uint32_t totalTracks_ = 0;
-		uint32_t totalAircrafts_ = 0;
-		uint32_t aircraftTracked_ = 0;
+		// Written by the EuroScope thread only, published to the presence thread as a whole
+		PluginState state_;
+		alignas(CACHE_LINE_SIZE) Seqlock<PluginState> sharedState_;
+		SessionTracks sessionTracks_; // "My session tracks" list membership, its size is totalTracks
+		CFlightPlanList sessionList_;
+		TrackTimer trackTimer_;
+		int64_t tagNow_ = 0; // OnTimer's clock, OnGetTagItem is too hot to read the time itself
+		ControlTimeStats controlTimes_; // what trackTimer_ intervals lasted, persisted across sessions
+		BadgeEngine badges_;
+		RateCounter<60> handoffsHour_{ 60 }; // feeds the handoffs per hour badge counter
+		uint32_t sweatboxConnections_ = 0;
+		uint32_t onFireCount_ = 0;
+		bool badgeUnlocked_ = false; // since the last poll, the presence shows it
+		MovementCounters movements_;
+		std::string myAirport_; // of my callsign, movements elsewhere are not counted
+		bool movementRecorded_ = false; // since the last poll
+		RunwayCache runways_;
+		size_t runwayElements_ = 0; // sector file runway elements walked by the last rebuild
+		LatencyHistogram runwayRebuildUs_;
+
+		HandoffTracker handoffTracker_;
+		SectorForecast sectorForecast_;
+		ControllerRegistry controllerRegistry_;
+		TargetGrid targetGrid_;
+		int64_t lastTargetExpiry_ = 0;
+		WorkloadEstimator workload_{ ONFIRE_THRESHOLD, ONFIRE_RELEASE_THRESHOLD };
+		alignas(CACHE_LINE_SIZE) VoiceStats voiceStats_; // written from the audio thread
+		alignas(CACHE_LINE_SIZE) CommsStats commsStats_;
+		MetarCache metarCache_;
+		SharedPresence sharedPresence_; // opened for the thread's lifetime, heartbeat from OnTimer
+		std::atomic<uint32_t> sharedInstances_{ 1 }; // live instances at the last heartbeat
+		FlightRecorder recorder_;
+		SessionRecorder session_;
+		MessageQueue messages_{ MESSAGE_DEDUPE_SECONDS, MESSAGE_BURST, MESSAGE_REFILL_SECONDS };
+		uint64_t lastTimerNs_ = 0;
+
+		// Event to Discord write latency in microseconds, per ChangeCause, written by the presence thread
+		std::array<LatencyHistogram, static_cast<size_t>(ChangeCause::COUNT)> latency_;
+		std::atomic<uint32_t> writtenChange_{ 0 }; // last changeSequence the presence thread has seen
+		uint64_t trackChangeNs_ = 0; // first tracking change since the last poll
+
+		// Transition detector, EuroScope thread
+		int lastEuroscopeConnection_ = -1; // GetConnectionType() at the last refresh
+		bool selfRoleChanged_ = false;     // observer to controller or back, seen in a position update
+
+		// Wakes the presence thread ahead of its one second tick
+		std::mutex wakeMutex_;
+		std::condition_variable wake_;
+		bool wakeRequested_ = false;
+
+		// Presence thread only, frames are sent when they change and within Discord's budget
+		PresenceFrame lastFrame_;
+		SlidingWindowLimit<DISCORD_UPDATE_LIMIT> discordBudget_{ DISCORD_UPDATE_WINDOW_NS };
+		std::atomic<bool> resendPresence_{ true }; // set when Discord (re)connects
+		bool presenceSettled_ = false;              // last pass had nothing new to send
+
+		// Adaptive cadence: the SDK poll on the EuroScope thread, the presence thread's wakeups
+		AdaptiveInterval dataInterval_{ DATA_INTERVAL_MIN, DATA_INTERVAL_MAX, DATA_INTERVAL_INITIAL };
+		int nextDataRefresh_ = 0; // OnTimer counter
+		int nextTrackReconcile_ = 0; // OnTimer counter
+		int idleRotations_ = 0;
+		PresenceCadence presenceCadence_;
+		std::atomic<int64_t> presenceWaitMs_{ PRESENCE_INTERVAL_MIN_MS }; // PRESENCE_PARKED while parked
+		RateCounter<12> presenceWakeups_{ 5 };
+		std::atomic<uint64_t> totalWakeups_{ 0 };
 
     };
 } // namespace rpc
\ No newline at end of file
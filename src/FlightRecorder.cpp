@@ -0,0 +1,174 @@
+#include "FlightRecorder.h"
+#include <cstdio>
+#include <iterator>
+
+using namespace rpc;
+
+void FlightRecorder::flushCallbacks()
+{
+    for (size_t i = 0; i < callbackCounts_.size(); ++i) {
+        uint32_t count = callbackCounts_[i].exchange(0, std::memory_order_relaxed);
+        if (count > 0) record(EventType::CALLBACKS, static_cast<uint16_t>(i), count);
+    }
+}
+
+std::vector<FlightRecorder::Event> FlightRecorder::snapshot() const
+{
+    uint64_t head = head_.load(std::memory_order_acquire);
+    uint64_t first = head > CAPACITY ? head - CAPACITY : 0;
+
+    std::vector<Event> events;
+    events.reserve(static_cast<size_t>(head - first));
+    for (uint64_t index = first; index < head; ++index) {
+        const Slot& slot = slots_[index & (CAPACITY - 1)];
+        uint64_t before = slot.sequence.load(std::memory_order_acquire);
+        uint64_t timestamp = slot.timestamp.load(std::memory_order_relaxed);
+        uint64_t payload = slot.payload.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (before != index + 1 || slot.sequence.load(std::memory_order_relaxed) != before) continue;
+
+        Event event;
+        event.timestamp = timestamp;
+        event.type = static_cast<uint16_t>(payload);
+        event.detail = static_cast<uint16_t>(payload >> 16);
+        event.value = static_cast<uint32_t>(payload >> 32);
+        events.push_back(event);
+    }
+    return events;
+}
+
+bool FlightRecorder::dump(const std::string& path)
+{
+    std::vector<Event> events = snapshot();
+
+    FileHeader header{};
+    header.magic = FILE_MAGIC;
+    header.version = FILE_VERSION;
+    header.count = static_cast<uint32_t>(events.size());
+    header.wallClockNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    header.steadyNs = now();
+
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) return false;
+    bool written = std::fwrite(&header, sizeof(header), 1, file) == 1
+        && (events.empty() || std::fwrite(events.data(), sizeof(Event), events.size(), file) == events.size());
+    written = std::fclose(file) == 0 && written;
+
+    record(EventType::DUMP, 0, header.count);
+    return written;
+}
+
+FlightRecorder::LoadResult FlightRecorder::load(const std::string& path, FileHeader& header, std::vector<Event>& events)
+{
+    events.clear();
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) return LoadResult::UNREADABLE;
+
+    header = FileHeader{};
+    if (std::fread(&header, sizeof(header), 1, file) != 1 || header.magic != FILE_MAGIC) {
+        std::fclose(file);
+        return LoadResult::NOT_A_DUMP;
+    }
+    if (header.version != FILE_VERSION) {
+        std::fclose(file);
+        return LoadResult::UNSUPPORTED_VERSION;
+    }
+
+    events.resize(header.count);
+    size_t read = events.empty() ? 0 : std::fread(events.data(), sizeof(Event), events.size(), file);
+    std::fclose(file);
+    bool complete = read == events.size();
+    events.resize(read);
+    return complete ? LoadResult::OK : LoadResult::TRUNCATED;
+}
+
+uint32_t FlightRecorder::hashText(std::string_view text)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : text) hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+    return static_cast<uint32_t>(hash ^ (hash >> 32));
+}
+
+const char* FlightRecorder::typeName(uint16_t type)
+{
+    switch (static_cast<EventType>(type)) {
+    case EventType::CALLBACKS: return "callbacks";
+    case EventType::STATE_CHANGE: return "state";
+    case EventType::PRESENCE_SENT: return "presence-sent";
+    case EventType::PRESENCE_SUPPRESSED: return "presence-suppressed";
+    case EventType::DISCORD_READY: return "discord-ready";
+    case EventType::DISCORD_DISCONNECTED: return "discord-disconnected";
+    case EventType::DISCORD_ERROR: return "discord-error";
+    case EventType::SCHEDULER_OVERRUN: return "overrun";
+    case EventType::LEADER_CHANGE: return "leader";
+    case EventType::ON_FIRE_CHANGE: return "on-fire";
+    case EventType::DUMP: return "dump";
+    default: return "unknown";
+    }
+}
+
+const char* FlightRecorder::callbackName(uint16_t callback)
+{
+    static constexpr const char* names[] = {
+        "OnTimer",
+        "OnFlightPlanControllerAssignedDataUpdate",
+        "OnFlightPlanDisconnect",
+        "OnFlightPlanFlightPlanDataUpdate",
+        "OnRadarTargetPositionUpdate",
+        "OnControllerPositionUpdate",
+        "OnControllerDisconnect",
+        "OnVoiceTransmit",
+        "OnVoiceReceiveStarted",
+        "OnCompileFrequencyChat",
+        "OnCompilePrivateChat",
+        "OnNewMetarReceived",
+        "OnCompileCommand",
+        "OnGetTagItem",
+        "OnAirportRunwayActivityChanged"
+    };
+    static_assert(std::size(names) == static_cast<size_t>(Callback::COUNT), "one name per callback");
+    return callback < std::size(names) ? names[callback] : "unknown";
+}
+
+const char* FlightRecorder::stateName(uint32_t state)
+{
+    // Mirrors the State enum of the plugin
+    static constexpr const char* names[] = { "IDLE", "CONTROLLING", "OBSERVING", "SWEATBOX", "PLAYBACK" };
+    return state < std::size(names) ? names[state] : "unknown";
+}
+
+std::string FlightRecorder::describe(const Event& event)
+{
+    switch (static_cast<EventType>(event.type)) {
+    case EventType::CALLBACKS:
+        return std::string(callbackName(event.detail)) + " x" + std::to_string(event.value);
+    case EventType::STATE_CHANGE:
+        return std::string(stateName(event.detail)) + " -> " + stateName(event.value);
+    case EventType::PRESENCE_SENT: {
+        char hash[16];
+        std::snprintf(hash, sizeof(hash), "%08x", event.value);
+        return std::string("text ") + hash;
+    }
+    case EventType::PRESENCE_SUPPRESSED:
+        switch (static_cast<SuppressReason>(event.detail)) {
+        case SuppressReason::NOT_LEADER: return "not leader";
+        case SuppressReason::RATE_LIMITED: return "rate limited";
+        default: return "disabled";
+        }
+    case EventType::DISCORD_DISCONNECTED:
+    case EventType::DISCORD_ERROR:
+        return "code " + std::to_string(static_cast<int32_t>(event.value));
+    case EventType::SCHEDULER_OVERRUN:
+        return std::string(event.detail == static_cast<uint16_t>(Scheduler::PRESENCE_THREAD) ? "presence thread" : "EuroScope timer")
+            + " " + std::to_string(event.value) + " ms late";
+    case EventType::LEADER_CHANGE:
+        return event.value ? "became leader" : "follower";
+    case EventType::ON_FIRE_CHANGE:
+        return event.value ? "on" : "off";
+    case EventType::DUMP:
+        return std::to_string(event.value) + " events";
+    default:
+        return std::to_string(event.detail) + " " + std::to_string(event.value);
+    }
+}
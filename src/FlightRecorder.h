@@ -0,0 +1,148 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace rpc {
+    // Black-box of recent plugin activity. A fixed ring of 16 byte events that every thread appends
+    // to with one fetch_add and a few relaxed stores, always on. Each slot carries the index it was
+    // written for, so a dump taken while other threads record skips torn slots instead of locking.
+    // High rate SDK callbacks are only counted and flushed once per second as one event per
+    // callback, which keeps about ten minutes of history in 384 KB.
+    class FlightRecorder
+    {
+    public:
+        static constexpr size_t CAPACITY = 16384; // events, power of two
+        static constexpr uint32_t FILE_MAGIC = 0x52464545; // "EEFR"
+        static constexpr uint32_t FILE_VERSION = 1;
+
+        enum class EventType : uint16_t {
+            CALLBACKS = 1,        // detail: Callback, value: calls during the last flush period
+            STATE_CHANGE,         // detail: previous State, value: new State
+            PRESENCE_SENT,        // value: presence text hash
+            PRESENCE_SUPPRESSED,  // detail: SuppressReason
+            DISCORD_READY,
+            DISCORD_DISCONNECTED, // value: error code
+            DISCORD_ERROR,        // value: error code
+            SCHEDULER_OVERRUN,    // detail: Scheduler, value: milliseconds late
+            LEADER_CHANGE,        // value: 1 when this instance became leader
+            ON_FIRE_CHANGE,       // value: 1 when on fire
+            DUMP,                 // value: events in the dump
+            COUNT
+        };
+
+        enum class Callback : uint16_t {
+            TIMER = 0,
+            CONTROLLER_ASSIGNED_DATA,
+            FLIGHT_PLAN_DISCONNECT,
+            FLIGHT_PLAN_DATA,
+            RADAR_TARGET_POSITION,
+            CONTROLLER_POSITION,
+            CONTROLLER_DISCONNECT,
+            VOICE_TRANSMIT,
+            VOICE_RECEIVE,
+            FREQUENCY_CHAT,
+            PRIVATE_CHAT,
+            METAR,
+            COMMAND,
+            TAG_ITEM,
+            RUNWAY_ACTIVITY,
+            COUNT
+        };
+
+        enum class SuppressReason : uint16_t {
+            DISABLED = 0, // presence turned off by the user
+            NOT_LEADER,   // another EuroScope instance renders the presence
+            RATE_LIMITED  // frame changed but the Discord update budget is spent
+        };
+
+        enum class Scheduler : uint16_t {
+            EUROSCOPE_TIMER = 0,
+            PRESENCE_THREAD
+        };
+
+        struct Event {
+            uint64_t timestamp; // steady clock nanoseconds
+            uint16_t type;
+            uint16_t detail;
+            uint32_t value;
+        };
+        static_assert(sizeof(Event) == 16, "events are packed in two words");
+
+        // Dump file layout: header, then count events oldest first
+        struct FileHeader {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t count;
+            uint32_t reserved;
+            int64_t wallClockNs; // system clock when dumped
+            uint64_t steadyNs;   // steady clock when dumped, maps event timestamps to wall time
+        };
+
+        void record(EventType type, uint16_t detail = 0, uint32_t value = 0)
+        {
+            uint64_t timestamp = now();
+            uint64_t index = head_.fetch_add(1, std::memory_order_relaxed);
+            Slot& slot = slots_[index & (CAPACITY - 1)];
+            slot.sequence.store(0, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            slot.timestamp.store(timestamp, std::memory_order_relaxed);
+            slot.payload.store(static_cast<uint64_t>(type) | static_cast<uint64_t>(detail) << 16 | static_cast<uint64_t>(value) << 32, std::memory_order_relaxed);
+            slot.sequence.store(index + 1, std::memory_order_release);
+        }
+
+        void countCallback(Callback callback)
+        {
+            callbackCounts_[static_cast<size_t>(callback)].fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // Turns the callback counters into CALLBACKS events, called once per second
+        void flushCallbacks();
+
+        // Copies the ring oldest first. Events overwritten while copying are skipped.
+        std::vector<Event> snapshot() const;
+        // Writes the snapshot to path, false on I/O error
+        bool dump(const std::string& path);
+
+        enum class LoadResult {
+            OK,
+            UNREADABLE,          // errno tells why
+            NOT_A_DUMP,
+            UNSUPPORTED_VERSION,
+            TRUNCATED            // events holds what was read
+        };
+        // Reads a dump back, what the decoder tool prints
+        static LoadResult load(const std::string& path, FileHeader& header, std::vector<Event>& events);
+        uint64_t recorded() const { return head_.load(std::memory_order_relaxed); }
+
+        static uint64_t now()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        // FNV-1a folded to 32 bits, tells presence frames apart without storing their text
+        static uint32_t hashText(std::string_view text);
+
+        static const char* typeName(uint16_t type);
+        static const char* callbackName(uint16_t callback);
+        static const char* stateName(uint32_t state);
+        // Detail and value of an event in words: "OnTimer x3", "became leader"
+        static std::string describe(const Event& event);
+
+    private:
+        struct Slot {
+            std::atomic<uint64_t> sequence{ 0 }; // index + 1 once written, 0 while being written
+            std::atomic<uint64_t> timestamp{ 0 };
+            std::atomic<uint64_t> payload{ 0 };
+        };
+
+        std::atomic<uint64_t> head_{ 0 };
+        std::array<std::atomic<uint32_t>, static_cast<size_t>(Callback::COUNT)> callbackCounts_{};
+        std::array<Slot, CAPACITY> slots_;
+    };
+} // namespace rpc
@@ -0,0 +1,18 @@
+#pragma once
+#include <cmath>
+
+namespace rpc::geo {
+    constexpr double EARTH_RADIUS_NM = 3440.065;
+    constexpr double DEG_TO_RAD = 3.14159265358979323846 / 180.0;
+
+    // Great circle distance (haversine) in nautical miles
+    inline double distanceNm(double lat1, double lon1, double lat2, double lon2)
+    {
+        double dLat = (lat2 - lat1) * DEG_TO_RAD;
+        double dLon = (lon2 - lon1) * DEG_TO_RAD;
+        double sinLat = std::sin(dLat * 0.5);
+        double sinLon = std::sin(dLon * 0.5);
+        double a = sinLat * sinLat + std::cos(lat1 * DEG_TO_RAD) * std::cos(lat2 * DEG_TO_RAD) * sinLon * sinLon;
+        return 2.0 * EARTH_RADIUS_NM * std::asin(std::sqrt(std::fmin(a, 1.0)));
+    }
+} // namespace rpc::geo
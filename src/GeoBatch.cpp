@@ -0,0 +1,294 @@
+#include "GeoBatch.h"
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include "Geo.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define RPC_GEO_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define RPC_TARGET_AVX2
+#else
+#define RPC_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+using namespace rpc::geo;
+
+namespace {
+    struct UnitVector {
+        float x, y, z;
+    };
+
+    UnitVector toUnitVector(double latitude, double longitude)
+    {
+        double lat = latitude * DEG_TO_RAD;
+        double lon = longitude * DEG_TO_RAD;
+        return { static_cast<float>(std::cos(lat) * std::cos(lon)),
+                 static_cast<float>(std::cos(lat) * std::sin(lon)),
+                 static_cast<float>(std::sin(lat)) };
+    }
+
+    // Squared chord length between two points of the unit sphere for a given arc
+    float chordSquared(double rangeNm)
+    {
+        double halfAngle = std::fmin(rangeNm / EARTH_RADIUS_NM, 3.14159265358979323846) * 0.5;
+        double chord = 2.0 * std::sin(halfAngle);
+        return static_cast<float>(chord * chord);
+    }
+
+    // Past this half chord the arcsine flattens and float loses the distance: 152 degrees of arc,
+    // 9100 nm. Beyond it the angle comes from the sum of the unit vectors instead, |a + b| = 2 cos(t/2)
+    // so t = pi - 2 asin(|a + b| / 2), where the arcsine argument stays below 0.25.
+    constexpr float WIDE_HALF_CHORD = 0.97f;
+    constexpr float PI_F = 3.14159265358979323846f;
+
+    void distancesScalar(UnitVector ref, const PointBatch& batch, size_t begin, float* out)
+    {
+        const float* x = batch.x();
+        const float* y = batch.y();
+        const float* z = batch.z();
+        for (size_t i = begin; i < batch.size(); ++i) {
+            float dx = x[i] - ref.x, dy = y[i] - ref.y, dz = z[i] - ref.z;
+            float halfChord = std::sqrt(dx * dx + dy * dy + dz * dz) * 0.5f;
+            if (halfChord <= WIDE_HALF_CHORD) {
+                out[i] = static_cast<float>(2.0 * EARTH_RADIUS_NM) * std::asin(halfChord);
+                continue;
+            }
+            float sx = x[i] + ref.x, sy = y[i] + ref.y, sz = z[i] + ref.z;
+            float halfSum = std::sqrt(sx * sx + sy * sy + sz * sz) * 0.5f;
+            out[i] = static_cast<float>(EARTH_RADIUS_NM) * (PI_F - 2.0f * std::asin(halfSum));
+        }
+    }
+
+    size_t countScalar(UnitVector ref, const PointBatch& batch, size_t begin, float threshold)
+    {
+        const float* x = batch.x();
+        const float* y = batch.y();
+        const float* z = batch.z();
+        size_t count = 0;
+        for (size_t i = begin; i < batch.size(); ++i) {
+            float dx = x[i] - ref.x, dy = y[i] - ref.y, dz = z[i] - ref.z;
+            if (dx * dx + dy * dy + dz * dz <= threshold) ++count;
+        }
+        return count;
+    }
+
+#if RPC_GEO_X86
+    // Cephes asinf polynomial, valid on [0, 1]
+    RPC_TARGET_AVX2 __m256 asinAvx2(__m256 x)
+    {
+        const __m256 half = _mm256_set1_ps(0.5f);
+        __m256 large = _mm256_cmp_ps(x, half, _CMP_GT_OQ);
+        __m256 zLarge = _mm256_mul_ps(half, _mm256_sub_ps(_mm256_set1_ps(1.0f), x));
+        __m256 z = _mm256_blendv_ps(_mm256_mul_ps(x, x), zLarge, large);
+        __m256 s = _mm256_blendv_ps(x, _mm256_sqrt_ps(zLarge), large);
+
+        __m256 p = _mm256_set1_ps(4.2163199048e-2f);
+        p = _mm256_add_ps(_mm256_mul_ps(p, z), _mm256_set1_ps(2.4181311049e-2f));
+        p = _mm256_add_ps(_mm256_mul_ps(p, z), _mm256_set1_ps(4.5470025998e-2f));
+        p = _mm256_add_ps(_mm256_mul_ps(p, z), _mm256_set1_ps(7.4953002686e-2f));
+        p = _mm256_add_ps(_mm256_mul_ps(p, z), _mm256_set1_ps(1.6666752422e-1f));
+        p = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(p, z), s), s);
+
+        __m256 pLarge = _mm256_sub_ps(_mm256_set1_ps(1.57079632679f), _mm256_add_ps(p, p));
+        return _mm256_blendv_ps(p, pLarge, large);
+    }
+
+    RPC_TARGET_AVX2 size_t distancesAvx2(UnitVector ref, const PointBatch& batch, float* out)
+    {
+        const float* x = batch.x();
+        const float* y = batch.y();
+        const float* z = batch.z();
+        const __m256 refX = _mm256_set1_ps(ref.x);
+        const __m256 refY = _mm256_set1_ps(ref.y);
+        const __m256 refZ = _mm256_set1_ps(ref.z);
+        const __m256 half = _mm256_set1_ps(0.5f);
+        const __m256 one = _mm256_set1_ps(1.0f);
+        const __m256 wideLimit = _mm256_set1_ps(WIDE_HALF_CHORD);
+        const __m256 radius = _mm256_set1_ps(static_cast<float>(EARTH_RADIUS_NM));
+        const __m256 pi = _mm256_set1_ps(PI_F);
+
+        size_t i = 0;
+        for (; i + 8 <= batch.size(); i += 8) {
+            __m256 px = _mm256_loadu_ps(x + i), py = _mm256_loadu_ps(y + i), pz = _mm256_loadu_ps(z + i);
+            __m256 dx = _mm256_sub_ps(px, refX);
+            __m256 dy = _mm256_sub_ps(py, refY);
+            __m256 dz = _mm256_sub_ps(pz, refZ);
+            __m256 d2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+            __m256 halfChord = _mm256_min_ps(_mm256_mul_ps(_mm256_sqrt_ps(d2), half), one);
+            // One arcsine per lane: of the half chord, or of the half sum past the wide limit
+            __m256 sx = _mm256_add_ps(px, refX);
+            __m256 sy = _mm256_add_ps(py, refY);
+            __m256 sz = _mm256_add_ps(pz, refZ);
+            __m256 s2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(sx, sx), _mm256_mul_ps(sy, sy)), _mm256_mul_ps(sz, sz));
+            __m256 halfSum = _mm256_min_ps(_mm256_mul_ps(_mm256_sqrt_ps(s2), half), one);
+            __m256 wide = _mm256_cmp_ps(halfChord, wideLimit, _CMP_GT_OQ);
+            __m256 arc = asinAvx2(_mm256_blendv_ps(halfChord, halfSum, wide));
+            __m256 angle = _mm256_blendv_ps(_mm256_add_ps(arc, arc), _mm256_sub_ps(pi, _mm256_add_ps(arc, arc)), wide);
+            _mm256_storeu_ps(out + i, _mm256_mul_ps(radius, angle));
+        }
+        return i;
+    }
+
+    RPC_TARGET_AVX2 size_t countAvx2(UnitVector ref, const PointBatch& batch, float threshold, size_t* processed)
+    {
+        const float* x = batch.x();
+        const float* y = batch.y();
+        const float* z = batch.z();
+        const __m256 refX = _mm256_set1_ps(ref.x);
+        const __m256 refY = _mm256_set1_ps(ref.y);
+        const __m256 refZ = _mm256_set1_ps(ref.z);
+        const __m256 limit = _mm256_set1_ps(threshold);
+
+        size_t count = 0;
+        size_t i = 0;
+        for (; i + 8 <= batch.size(); i += 8) {
+            __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(x + i), refX);
+            __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(y + i), refY);
+            __m256 dz = _mm256_sub_ps(_mm256_loadu_ps(z + i), refZ);
+            __m256 d2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+            int mask = _mm256_movemask_ps(_mm256_cmp_ps(d2, limit, _CMP_LE_OQ));
+            count += static_cast<size_t>(std::popcount(static_cast<unsigned>(mask)));
+        }
+        *processed = i;
+        return count;
+    }
+
+    bool detectAvx2()
+    {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7) return false;
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) return false;
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+#endif
+}
+
+void PointBatch::reserve(size_t capacity)
+{
+    latitude_.reserve(capacity);
+    longitude_.reserve(capacity);
+    x_.reserve(capacity);
+    y_.reserve(capacity);
+    z_.reserve(capacity);
+}
+
+void PointBatch::clear()
+{
+    latitude_.clear();
+    longitude_.clear();
+    x_.clear();
+    y_.clear();
+    z_.clear();
+}
+
+void PointBatch::push_back(double latitude, double longitude)
+{
+    UnitVector v = toUnitVector(latitude, longitude);
+    latitude_.push_back(latitude);
+    longitude_.push_back(longitude);
+    x_.push_back(v.x);
+    y_.push_back(v.y);
+    z_.push_back(v.z);
+}
+
+void PointBatch::set(size_t index, double latitude, double longitude)
+{
+    UnitVector v = toUnitVector(latitude, longitude);
+    latitude_[index] = latitude;
+    longitude_[index] = longitude;
+    x_[index] = v.x;
+    y_[index] = v.y;
+    z_[index] = v.z;
+}
+
+void PointBatch::swapRemove(size_t index)
+{
+    size_t last = size() - 1;
+    if (index != last) {
+        latitude_[index] = latitude_[last];
+        longitude_[index] = longitude_[last];
+        x_[index] = x_[last];
+        y_[index] = y_[last];
+        z_[index] = z_[last];
+    }
+    latitude_.pop_back();
+    longitude_.pop_back();
+    x_.pop_back();
+    y_.pop_back();
+    z_.pop_back();
+}
+
+bool rpc::geo::hasAvx2()
+{
+#if RPC_GEO_X86
+    static const bool supported = detectAvx2();
+    return supported;
+#else
+    return false;
+#endif
+}
+
+namespace {
+    std::atomic<bool> avx2Enabled{ true };
+
+    bool useAvx2()
+    {
+        return avx2Enabled.load(std::memory_order_relaxed) && hasAvx2();
+    }
+}
+
+void rpc::geo::setAvx2Enabled(bool enabled)
+{
+    avx2Enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void rpc::geo::distancesNm(double latitude, double longitude, const PointBatch& batch, float* out)
+{
+    UnitVector ref = toUnitVector(latitude, longitude);
+    size_t begin = 0;
+#if RPC_GEO_X86
+    if (useAvx2()) begin = distancesAvx2(ref, batch, out);
+#endif
+    distancesScalar(ref, batch, begin, out);
+}
+
+size_t rpc::geo::countWithin(double latitude, double longitude, const PointBatch& batch, double rangeNm)
+{
+    UnitVector ref = toUnitVector(latitude, longitude);
+    float threshold = chordSquared(rangeNm);
+    size_t count = 0;
+    size_t begin = 0;
+#if RPC_GEO_X86
+    if (useAvx2()) count = countAvx2(ref, batch, threshold, &begin);
+#endif
+    return count + countScalar(ref, batch, begin, threshold);
+}
+
+RangeFilter::RangeFilter(double latitude, double longitude, double rangeNm)
+{
+    UnitVector ref = toUnitVector(latitude, longitude);
+    x_ = ref.x;
+    y_ = ref.y;
+    z_ = ref.z;
+    threshold_ = chordSquared(rangeNm);
+}
+
+bool RangeFilter::contains(const PointBatch& batch, size_t index) const
+{
+    float dx = batch.x()[index] - x_, dy = batch.y()[index] - y_, dz = batch.z()[index] - z_;
+    return dx * dx + dy * dy + dz * dz <= threshold_;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+namespace rpc::geo {
+    // Structure of arrays batch of positions. Alongside lat/lon each point keeps its unit vector on the
+    // sphere (computed once on insertion) so batched distance queries need no trigonometry per point.
+    class PointBatch
+    {
+    public:
+        size_t size() const { return latitude_.size(); }
+        void reserve(size_t capacity);
+        void clear();
+
+        void push_back(double latitude, double longitude);
+        void set(size_t index, double latitude, double longitude);
+        // Moves the last point into index, mirrors the swap removal of the owning containers
+        void swapRemove(size_t index);
+
+        double latitude(size_t index) const { return latitude_[index]; }
+        double longitude(size_t index) const { return longitude_[index]; }
+        const float* x() const { return x_.data(); }
+        const float* y() const { return y_.data(); }
+        const float* z() const { return z_.data(); }
+
+    private:
+        std::vector<double> latitude_;
+        std::vector<double> longitude_;
+        std::vector<float> x_;
+        std::vector<float> y_;
+        std::vector<float> z_;
+    };
+
+    // Great circle distances in nm from the reference to every point of the batch (out holds batch.size()).
+    // Uses AVX2 when the CPU supports it, checked once at runtime. Measured against distanceNm the error
+    // stays under 0.001 nm up to 3000 nm and under 0.005 nm anywhere: past 152 degrees of arc, where
+    // the arcsine of the half chord flattens, the angle comes from the sum of the unit vectors.
+    void distancesNm(double latitude, double longitude, const PointBatch& batch, float* out);
+    // Number of points within rangeNm, compares chord lengths and never leaves the vector unit
+    size_t countWithin(double latitude, double longitude, const PointBatch& batch, double rangeNm);
+
+    // The chord comparison of countWithin for one point at a time, reference and range set once.
+    // A default constructed filter contains nothing.
+    class RangeFilter
+    {
+    public:
+        RangeFilter() = default;
+        RangeFilter(double latitude, double longitude, double rangeNm);
+
+        bool contains(const PointBatch& batch, size_t index) const;
+
+    private:
+        float x_ = 0.0f, y_ = 0.0f, z_ = 0.0f;
+        float threshold_ = -1.0f;
+    };
+
+    bool hasAvx2();
+    // Tests and benchmarks only: false sends every batch down the scalar path, even on AVX2 machines
+    void setAvx2Enabled(bool enabled);
+} // namespace rpc::geo
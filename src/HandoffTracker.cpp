@@ -0,0 +1,89 @@
+#include "HandoffTracker.h"
+
+using namespace rpc;
+
+uint32_t HandoffTracker::update(PackedCallsign flightPlan, bool trackingIsMe, bool handoffPending, bool handoffTargetIsMe)
+{
+    uint8_t newFlags = 0;
+    if (trackingIsMe) {
+        newFlags |= TRACKED_BY_ME;
+        if (handoffPending && !handoffTargetIsMe) newFlags |= OUTBOUND_PENDING;
+    }
+    else if (handoffPending && handoffTargetIsMe) {
+        newFlags |= INBOUND_PENDING;
+    }
+
+    uint8_t* state = states_.find(flightPlan);
+    uint8_t oldFlags = state ? *state : 0;
+    if (oldFlags == newFlags) return 0;
+
+    if ((newFlags & INBOUND_PENDING) && !(oldFlags & INBOUND_PENDING))
+        inboundOffered_.fetch_add(1, std::memory_order_relaxed);
+    if ((newFlags & OUTBOUND_PENDING) && !(oldFlags & OUTBOUND_PENDING))
+        outboundInitiated_.fetch_add(1, std::memory_order_relaxed);
+    uint32_t completed = 0;
+    if ((oldFlags & INBOUND_PENDING) && (newFlags & TRACKED_BY_ME)) {
+        inbound_.fetch_add(1, std::memory_order_relaxed);
+        ++completed;
+    }
+    if ((oldFlags & OUTBOUND_PENDING) && !(newFlags & TRACKED_BY_ME)) {
+        outbound_.fetch_add(1, std::memory_order_relaxed);
+        ++completed;
+    }
+
+    applyGauges(oldFlags, newFlags);
+
+    if (newFlags == 0) states_.erase(flightPlan);
+    else if (state) *state = newFlags;
+    else *states_.tryEmplace(flightPlan).first = newFlags;
+
+    return completed;
+}
+
+void HandoffTracker::remove(PackedCallsign flightPlan)
+{
+    uint8_t* state = states_.find(flightPlan);
+    if (!state) return;
+    applyGauges(*state, 0);
+    states_.erase(flightPlan);
+}
+
+bool HandoffTracker::isTrackedByMe(PackedCallsign flightPlan) const
+{
+    const uint8_t* state = states_.find(flightPlan);
+    return state && (*state & TRACKED_BY_ME);
+}
+
+void HandoffTracker::reset()
+{
+    states_.clear();
+    inbound_ = 0;
+    outbound_ = 0;
+    inboundOffered_ = 0;
+    outboundInitiated_ = 0;
+    inboundPending_ = 0;
+    outboundPending_ = 0;
+}
+
+HandoffTracker::Counters HandoffTracker::getCounters() const
+{
+    Counters counters;
+    counters.inbound = inbound_.load(std::memory_order_relaxed);
+    counters.outbound = outbound_.load(std::memory_order_relaxed);
+    counters.inboundOffered = inboundOffered_.load(std::memory_order_relaxed);
+    counters.outboundInitiated = outboundInitiated_.load(std::memory_order_relaxed);
+    counters.inboundPending = inboundPending_.load(std::memory_order_relaxed);
+    counters.outboundPending = outboundPending_.load(std::memory_order_relaxed);
+    return counters;
+}
+
+void HandoffTracker::applyGauges(uint8_t oldFlags, uint8_t newFlags)
+{
+    uint8_t added = static_cast<uint8_t>(newFlags & ~oldFlags);
+    uint8_t removed = static_cast<uint8_t>(oldFlags & ~newFlags);
+
+    if (added & INBOUND_PENDING) inboundPending_.fetch_add(1, std::memory_order_relaxed);
+    if (removed & INBOUND_PENDING) inboundPending_.fetch_sub(1, std::memory_order_relaxed);
+    if (added & OUTBOUND_PENDING) outboundPending_.fetch_add(1, std::memory_order_relaxed);
+    if (removed & OUTBOUND_PENDING) outboundPending_.fetch_sub(1, std::memory_order_relaxed);
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include "Callsign.h"
+
+namespace rpc {
+    // Handoff state machine driven by controller assigned data updates.
+    // Only flight plans with a live handoff or tracked by me are kept in the table,
+    // every event is a single probe and a few counter updates.
+    class HandoffTracker
+    {
+    public:
+        enum Flags : uint8_t {
+            TRACKED_BY_ME = 1 << 0,
+            OUTBOUND_PENDING = 1 << 1, // I am tracking, handoff offered to someone else
+            INBOUND_PENDING = 1 << 2   // Someone else is handing off to me
+        };
+
+        struct Counters {
+            uint32_t inbound = 0;           // handoffs to me accepted
+            uint32_t outbound = 0;          // handoffs from me completed
+            uint32_t inboundOffered = 0;
+            uint32_t outboundInitiated = 0;
+            uint32_t inboundPending = 0;
+            uint32_t outboundPending = 0;
+        };
+
+        // Returns the handoffs this update completed, inbound or outbound: 0 or 1
+        uint32_t update(PackedCallsign flightPlan, bool trackingIsMe, bool handoffPending, bool handoffTargetIsMe);
+        void remove(PackedCallsign flightPlan);
+        void reset();
+        bool isTrackedByMe(PackedCallsign flightPlan) const;
+
+        // Safe to call from any thread
+        Counters getCounters() const;
+        uint32_t getInbound() const { return inbound_.load(std::memory_order_relaxed); }
+        uint32_t getOutbound() const { return outbound_.load(std::memory_order_relaxed); }
+
+    private:
+        void applyGauges(uint8_t oldFlags, uint8_t newFlags);
+
+    private:
+        CallsignMap<uint8_t> states_{ 256 };
+
+        std::atomic<uint32_t> inbound_{ 0 };
+        std::atomic<uint32_t> outbound_{ 0 };
+        std::atomic<uint32_t> inboundOffered_{ 0 };
+        std::atomic<uint32_t> outboundInitiated_{ 0 };
+        std::atomic<uint32_t> inboundPending_{ 0 };
+        std::atomic<uint32_t> outboundPending_{ 0 };
+    };
+} // namespace rpc
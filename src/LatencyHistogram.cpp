@@ -0,0 +1,88 @@
+#include "LatencyHistogram.h"
+#include <algorithm>
+#include <bit>
+
+using namespace rpc;
+
+void LatencyHistogram::record(uint64_t value, uint64_t count)
+{
+    value = std::min(value, MAX_VALUE);
+    counts_[bucketFor(value)].fetch_add(count, std::memory_order_relaxed);
+    count_.fetch_add(count, std::memory_order_relaxed);
+    sum_.fetch_add(value * count, std::memory_order_relaxed);
+    if (value > max_.load(std::memory_order_relaxed)) max_.store(value, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other)
+{
+    merge(other.snapshot());
+}
+
+void LatencyHistogram::merge(const Snapshot& other)
+{
+    for (size_t i = 0; i < BUCKETS; ++i) {
+        if (other.counts[i]) counts_[i].fetch_add(other.counts[i], std::memory_order_relaxed);
+    }
+    count_.fetch_add(other.count, std::memory_order_relaxed);
+    sum_.fetch_add(other.sum, std::memory_order_relaxed);
+    if (other.max > getMax()) max_.store(other.max, std::memory_order_relaxed);
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const
+{
+    Snapshot result;
+    for (size_t i = 0; i < BUCKETS; ++i) result.counts[i] = getBucketCount(i);
+    result.count = getCount();
+    result.sum = sum_.load(std::memory_order_relaxed);
+    result.max = getMax();
+    return result;
+}
+
+void LatencyHistogram::reset()
+{
+    for (auto& bucket : counts_) bucket = 0;
+    count_ = 0;
+    sum_ = 0;
+    max_ = 0;
+}
+
+double LatencyHistogram::getMean() const
+{
+    uint64_t count = getCount();
+    return count ? static_cast<double>(sum_.load(std::memory_order_relaxed)) / count : 0.0;
+}
+
+uint64_t LatencyHistogram::percentile(double quantile) const
+{
+    uint64_t count = getCount();
+    if (count == 0) return 0;
+    uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::clamp(quantile, 0.0, 1.0) * count + 0.5));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKETS; ++i) {
+        seen += getBucketCount(i);
+        if (seen >= rank) return std::min(upperBound(i), getMax());
+    }
+    return getMax();
+}
+
+size_t LatencyHistogram::bucketFor(uint64_t value)
+{
+    value = std::min(value, MAX_VALUE);
+    if (value < 2 * SUB_BUCKET_HALF) return static_cast<size_t>(value);
+    int shift = std::bit_width(value) - SUB_BUCKET_BITS;
+    return static_cast<size_t>(shift) * SUB_BUCKET_HALF + static_cast<size_t>(value >> shift);
+}
+
+uint64_t LatencyHistogram::lowerBound(size_t bucket)
+{
+    if (bucket < 2 * SUB_BUCKET_HALF) return bucket;
+    size_t shift = bucket / SUB_BUCKET_HALF - 1;
+    return static_cast<uint64_t>(bucket % SUB_BUCKET_HALF + SUB_BUCKET_HALF) << shift;
+}
+
+uint64_t LatencyHistogram::upperBound(size_t bucket)
+{
+    if (bucket < 2 * SUB_BUCKET_HALF) return bucket;
+    size_t shift = bucket / SUB_BUCKET_HALF - 1;
+    return lowerBound(bucket) + (uint64_t(1) << shift) - 1;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace rpc {
+    // Log-linear histogram in the HdrHistogram layout: values below 32 get a bucket each, every
+    // power of two above is split in 16 linear sub-buckets, so any value up to 2^32 is known to
+    // within 1/16 in 464 counters (an hour in microseconds, a century in seconds). Recording is
+    // constant time and queries walk the fixed bucket array. One writer, readers on any thread;
+    // histograms of the same layout merge by adding counters.
+    class LatencyHistogram
+    {
+    public:
+        static constexpr int SUB_BUCKET_BITS = 5;
+        static constexpr size_t SUB_BUCKET_HALF = size_t(1) << (SUB_BUCKET_BITS - 1); // linear steps per power of two
+        static constexpr int VALUE_BITS = 32;
+        static constexpr uint64_t MAX_VALUE = (uint64_t(1) << VALUE_BITS) - 1; // larger values are clamped
+        static constexpr size_t BUCKETS = (VALUE_BITS - SUB_BUCKET_BITS + 2) * SUB_BUCKET_HALF;
+
+        // Plain copy of the counters, what gets persisted
+        struct Snapshot {
+            std::array<uint64_t, BUCKETS> counts{};
+            uint64_t count = 0;
+            uint64_t sum = 0;
+            uint64_t max = 0;
+        };
+
+        void record(uint64_t value, uint64_t count = 1);
+        void merge(const LatencyHistogram& other);
+        void merge(const Snapshot& other);
+        Snapshot snapshot() const;
+        void reset();
+
+        uint64_t getCount() const { return count_.load(std::memory_order_relaxed); }
+        uint64_t getMax() const { return max_.load(std::memory_order_relaxed); }
+        double getMean() const;
+        // Upper bound of the bucket holding the given quantile (0 to 1), 0 when empty
+        uint64_t percentile(double quantile) const;
+        uint64_t getBucketCount(size_t bucket) const { return counts_[bucket].load(std::memory_order_relaxed); }
+
+        static size_t bucketFor(uint64_t value);
+        static uint64_t lowerBound(size_t bucket);
+        static uint64_t upperBound(size_t bucket);
+
+    private:
+        std::array<std::atomic<uint64_t>, BUCKETS> counts_{};
+        std::atomic<uint64_t> count_{ 0 };
+        std::atomic<uint64_t> sum_{ 0 };
+        std::atomic<uint64_t> max_{ 0 };
+    };
+} // namespace rpc
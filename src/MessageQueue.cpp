@@ -0,0 +1,76 @@
+#include "MessageQueue.h"
+
+using namespace rpc;
+
+namespace {
+    uint32_t hashMessage(const std::string& sender, const std::string& text)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        for (char c : sender) hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+        hash = (hash ^ 0xff) * 1099511628211ull;
+        for (char c : text) hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+        return static_cast<uint32_t>(hash ^ (hash >> 32));
+    }
+}
+
+MessageQueue::MessageQueue(int64_t dedupeSeconds, uint32_t burst, int64_t refillSeconds)
+    : dedupeSeconds_(dedupeSeconds), budget_(burst, static_cast<uint64_t>(refillSeconds) * NS_PER_SECOND)
+{
+}
+
+MessageQueue::~MessageQueue()
+{
+    for (Node* node = takeAll(); node != nullptr;) {
+        Node* next = node->next;
+        delete node;
+        node = next;
+    }
+}
+
+bool MessageQueue::push(const std::string& sender, const std::string& text, int64_t nowSeconds)
+{
+    if (isDuplicate(hashMessage(sender, text), nowSeconds)) {
+        duplicates_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    if (pending_.fetch_add(1, std::memory_order_relaxed) >= MAX_PENDING) {
+        pending_.fetch_sub(1, std::memory_order_relaxed);
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    Node* node = new Node{ sender, text };
+    node->next = head_.load(std::memory_order_relaxed);
+    while (!head_.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed)) {}
+    return true;
+}
+
+bool MessageQueue::isDuplicate(uint32_t hash, int64_t nowSeconds)
+{
+    // Racy by design: two threads posting the same message at once may both get through
+    std::atomic<uint64_t>& slot = recent_[hash & (RECENT_SLOTS - 1)];
+    uint64_t previous = slot.load(std::memory_order_relaxed);
+    uint32_t seconds = static_cast<uint32_t>(nowSeconds);
+    if (previous != 0 && static_cast<uint32_t>(previous >> 32) == hash && seconds - static_cast<uint32_t>(previous) < dedupeSeconds_)
+        return true;
+    slot.store(static_cast<uint64_t>(hash) << 32 | seconds, std::memory_order_relaxed);
+    return false;
+}
+
+MessageQueue::Node* MessageQueue::takeAll()
+{
+    // The stack holds newest first, reverse it to show messages in the order they were posted
+    Node* node = head_.exchange(nullptr, std::memory_order_acquire);
+    Node* ordered = nullptr;
+    size_t count = 0;
+    while (node != nullptr) {
+        Node* next = node->next;
+        node->next = ordered;
+        ordered = node;
+        node = next;
+        ++count;
+    }
+    pending_.fetch_sub(count, std::memory_order_relaxed);
+    return ordered;
+}
+
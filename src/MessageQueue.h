@@ -0,0 +1,75 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include "TokenBucket.h"
+
+namespace rpc {
+    // Chat messages posted from any thread and shown from EuroScope's thread. Producers push onto a
+    // lock free stack; the single consumer takes the whole stack at once and replays it in order.
+    // Identical messages within the dedupe window are only counted, so an error storm costs a hash
+    // and a couple of atomics per call, and the consumer rate limits what reaches the chat.
+    class MessageQueue
+    {
+    public:
+        static constexpr size_t MAX_PENDING = 64;
+        static constexpr size_t RECENT_SLOTS = 16;
+
+        // burst messages at once, then one every refillSeconds
+        MessageQueue(int64_t dedupeSeconds, uint32_t burst, int64_t refillSeconds);
+        ~MessageQueue();
+
+        MessageQueue(const MessageQueue&) = delete;
+        MessageQueue& operator=(const MessageQueue&) = delete;
+
+        // Any thread. Returns false when the message was deduplicated or dropped.
+        bool push(const std::string& sender, const std::string& text, int64_t nowSeconds);
+
+        // Consumer thread only. Calls sink(sender, text) for each message let through, plus one
+        // summary line when messages were suppressed since the last one.
+        template <typename Sink>
+        void drain(int64_t nowSeconds, Sink&& sink)
+        {
+            uint64_t nowNs = static_cast<uint64_t>(nowSeconds) * NS_PER_SECOND;
+            for (Node* node = takeAll(); node != nullptr;) {
+                if (budget_.tryTake(nowNs)) sink(node->sender, node->text);
+                else dropped_.fetch_add(1, std::memory_order_relaxed);
+                Node* next = node->next;
+                delete node;
+                node = next;
+            }
+
+            if (dropped_.load(std::memory_order_relaxed) + duplicates_.load(std::memory_order_relaxed) == 0) return;
+            if (!budget_.tryTake(nowNs)) return;
+            uint64_t suppressed = dropped_.exchange(0, std::memory_order_relaxed) + duplicates_.exchange(0, std::memory_order_relaxed);
+            sink(std::string("Status"), std::to_string(suppressed) + " repeated or excess messages suppressed");
+        }
+
+        uint64_t getDropped() const { return dropped_.load(std::memory_order_relaxed); }
+        uint64_t getDuplicates() const { return duplicates_.load(std::memory_order_relaxed); }
+
+    private:
+        struct Node {
+            std::string sender;
+            std::string text;
+            Node* next = nullptr;
+        };
+
+        bool isDuplicate(uint32_t hash, int64_t nowSeconds);
+        Node* takeAll();
+
+    private:
+        static constexpr uint64_t NS_PER_SECOND = 1000000000;
+
+        int64_t dedupeSeconds_;
+
+        std::atomic<Node*> head_{ nullptr };
+        std::atomic<size_t> pending_{ 0 };
+        std::atomic<uint64_t> dropped_{ 0 };
+        std::atomic<uint64_t> duplicates_{ 0 };
+        std::array<std::atomic<uint64_t>, RECENT_SLOTS> recent_{}; // hash << 32 | seconds
+
+        TokenBucket budget_; // consumer side
+    };
+} // namespace rpc
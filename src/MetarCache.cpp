@@ -0,0 +1,244 @@
+#include "MetarCache.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+
+using namespace rpc;
+
+namespace {
+    bool isDigits(std::string_view text)
+    {
+        return !text.empty() && std::all_of(text.begin(), text.end(), [](char c) { return c >= '0' && c <= '9'; });
+    }
+
+    int toInt(std::string_view digits)
+    {
+        int value = 0;
+        for (char c : digits) value = value * 10 + (c - '0');
+        return value;
+    }
+
+    bool startsWith(std::string_view text, std::string_view prefix)
+    {
+        return text.substr(0, prefix.size()) == prefix;
+    }
+
+    bool endsWith(std::string_view text, std::string_view suffix)
+    {
+        return text.size() >= suffix.size() && text.substr(text.size() - suffix.size()) == suffix;
+    }
+
+    // "dddff(f)Gff(f)KT", "VRBffKT", also MPS / KMH converted to knots
+    bool parseWind(std::string_view token, Metar& metar)
+    {
+        double factor = 1.0;
+        if (endsWith(token, "KT")) token.remove_suffix(2);
+        else if (endsWith(token, "MPS")) { token.remove_suffix(3); factor = 1.943844; }
+        else if (endsWith(token, "KMH")) { token.remove_suffix(3); factor = 0.539957; }
+        else return false;
+        if (token.size() < 5) return false;
+
+        std::string_view direction = token.substr(0, 3);
+        if (direction != "VRB" && !isDigits(direction)) return false;
+
+        std::string_view speed = token.substr(3);
+        std::string_view gust;
+        if (size_t g = speed.find('G'); g != std::string_view::npos) {
+            gust = speed.substr(g + 1);
+            speed = speed.substr(0, g);
+            if (!isDigits(gust)) return false;
+        }
+        if (!isDigits(speed)) return false;
+
+        metar.windDirection = direction == "VRB" ? -1 : static_cast<int16_t>(toInt(direction));
+        metar.windSpeed = static_cast<int16_t>(toInt(speed) * factor + 0.5);
+        if (!gust.empty()) metar.windGust = static_cast<int16_t>(toInt(gust) * factor + 0.5);
+        return true;
+    }
+
+    // Statute miles: "10SM", "1/2SM", "M1/4SM"; whole is a preceding "1" of "1 1/2SM"
+    bool parseStatuteMiles(std::string_view token, int whole, Metar& metar)
+    {
+        if (!endsWith(token, "SM")) return false;
+        token.remove_suffix(2);
+        if (startsWith(token, "M") || startsWith(token, "P")) token.remove_prefix(1);
+
+        double miles = whole;
+        if (size_t slash = token.find('/'); slash != std::string_view::npos) {
+            std::string_view numerator = token.substr(0, slash);
+            std::string_view denominator = token.substr(slash + 1);
+            if (!isDigits(numerator) || !isDigits(denominator) || toInt(denominator) == 0) return false;
+            miles += static_cast<double>(toInt(numerator)) / toInt(denominator);
+        }
+        else if (isDigits(token)) miles += toInt(token);
+        else return false;
+
+        metar.visibility = std::min(9999, static_cast<int>(miles * 1609.344 + 0.5));
+        return true;
+    }
+
+    bool parseCloud(std::string_view token, Metar& metar)
+    {
+        bool ceilingLayer = startsWith(token, "BKN") || startsWith(token, "OVC");
+        size_t prefix = ceilingLayer ? 3 : (startsWith(token, "VV") ? 2 : 0);
+        if (prefix == 0) return startsWith(token, "FEW") || startsWith(token, "SCT") || token == "NSC" || token == "NCD" || token == "SKC" || token == "CLR";
+
+        std::string_view height = token.substr(prefix, 3);
+        if (!isDigits(height)) return true; // "///" height not reported
+        int feet = toInt(height) * 100;
+        if (metar.ceiling < 0 || feet < metar.ceiling) metar.ceiling = feet;
+        return true;
+    }
+
+    bool parseTemperature(std::string_view token, Metar& metar)
+    {
+        size_t slash = token.find('/');
+        if (slash == std::string_view::npos || slash == 0) return false;
+
+        auto parse = [](std::string_view value, int8_t& out) {
+            bool negative = startsWith(value, "M");
+            if (negative) value.remove_prefix(1);
+            if (value.size() != 2 || !isDigits(value)) return false;
+            out = static_cast<int8_t>(negative ? -toInt(value) : toInt(value));
+            return true;
+        };
+        if (!parse(token.substr(0, slash), metar.temperature)) return false;
+        if (!parse(token.substr(slash + 1), metar.dewpoint)) metar.dewpoint = metar.temperature;
+        metar.hasTemperature = true;
+        return true;
+    }
+
+    FlightCategory categorize(const Metar& metar)
+    {
+        if (metar.visibility < 0 && metar.ceiling < 0) return FlightCategory::UNKNOWN;
+        int visibility = metar.visibility < 0 ? 9999 : metar.visibility;
+        int ceiling = metar.ceiling < 0 ? 99999 : metar.ceiling;
+        if (ceiling < 500 || visibility < 1600) return FlightCategory::LIFR;
+        if (ceiling < 1000 || visibility < 4800) return FlightCategory::IFR;
+        if (ceiling <= 3000 || visibility <= 8000) return FlightCategory::MVFR;
+        return FlightCategory::VFR;
+    }
+}
+
+bool rpc::parseMetar(std::string_view report, Metar& metar)
+{
+    metar = Metar{};
+    size_t field = 0;
+    int pendingMiles = 0;
+
+    while (!report.empty()) {
+        size_t start = report.find_first_not_of(" \r\n\t=");
+        if (start == std::string_view::npos) break;
+        report.remove_prefix(start);
+        size_t end = report.find_first_of(" \r\n\t=");
+        std::string_view token = report.substr(0, end);
+        report.remove_prefix(end == std::string_view::npos ? report.size() : end);
+
+        if (field == 0 && (token == "METAR" || token == "SPECI")) continue;
+        if (field == 0) {
+            if (token.size() != 4) return false;
+            for (size_t i = 0; i < 4; ++i) metar.station[i] = static_cast<char>(std::toupper(static_cast<unsigned char>(token[i])));
+            ++field;
+            continue;
+        }
+        ++field;
+
+        // Trend and remarks describe other times, stop there
+        if (token == "RMK" || token == "TEMPO" || token == "BECMG" || token == "NOSIG") break;
+        if (token == "AUTO" || token == "COR" || endsWith(token, "Z")) continue;
+
+        if (token == "CAVOK") {
+            metar.visibility = 9999;
+            continue;
+        }
+        if (metar.windSpeed < 0 && parseWind(token, metar)) continue;
+        if (token.size() == 4 && isDigits(token) && metar.visibility < 0) {
+            metar.visibility = toInt(token);
+            continue;
+        }
+        if (token.size() == 1 && isDigits(token)) {
+            pendingMiles = toInt(token);
+            continue;
+        }
+        if (metar.visibility < 0 && parseStatuteMiles(token, pendingMiles, metar)) continue;
+        pendingMiles = 0;
+
+        if ((token[0] == 'Q' || token[0] == 'A') && token.size() == 5 && isDigits(token.substr(1))) {
+            int value = toInt(token.substr(1));
+            metar.qnh = static_cast<int16_t>(token[0] == 'Q' ? value : static_cast<int>(value * 0.338639 + 0.5));
+            continue;
+        }
+        if (parseCloud(token, metar)) continue;
+        if (!metar.hasTemperature) parseTemperature(token, metar);
+    }
+
+    if (metar.station[0] == '\0') return false;
+    metar.category = categorize(metar);
+    return true;
+}
+
+std::string rpc::formatMetar(const Metar& metar)
+{
+    // Written into one buffer, concatenating temporaries trips -Wrestrict in GCC 12
+    char text[48];
+    int length = 0;
+    if (metar.qnh > 0) length = std::snprintf(text, sizeof(text), "Q%d", metar.qnh);
+    if (metar.windSpeed >= 0) {
+        const char* separator = length > 0 ? ", " : "";
+        if (metar.windDirection < 0)
+            length += std::snprintf(text + length, sizeof(text) - length, "%swind VRB/%d", separator, metar.windSpeed);
+        else
+            length += std::snprintf(text + length, sizeof(text) - length, "%swind %03d/%d", separator, metar.windDirection, metar.windSpeed);
+        if (metar.windGust > 0) length += std::snprintf(text + length, sizeof(text) - length, "G%d", metar.windGust);
+    }
+    return std::string(text, length);
+}
+
+bool MetarCache::update(std::string_view station, std::string_view report, int64_t nowSeconds)
+{
+    Metar metar;
+    if (!parseMetar(report, metar)) return false;
+    metar.received = nowSeconds;
+
+    uint32_t key = packIcao(station.empty() ? std::string_view(metar.station) : station);
+    if (key == 0) return false;
+
+    for (size_t probe = 0; probe < CAPACITY; ++probe) {
+        Slot& slot = slots_[(key * 2654435761u + probe) & (CAPACITY - 1)];
+        uint32_t current = slot.key.load(std::memory_order_relaxed);
+        if (current == key) {
+            slot.metar.store(metar);
+            return true;
+        }
+        if (current == 0) {
+            // Value first, then the key: readers never see a station without its record
+            slot.metar.store(metar);
+            slot.key.store(key, std::memory_order_release);
+            size_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+std::optional<Metar> MetarCache::find(std::string_view station) const
+{
+    uint32_t key = packIcao(station);
+    if (key == 0) return std::nullopt;
+
+    for (size_t probe = 0; probe < CAPACITY; ++probe) {
+        const Slot& slot = slots_[(key * 2654435761u + probe) & (CAPACITY - 1)];
+        uint32_t current = slot.key.load(std::memory_order_acquire);
+        if (current == key) return slot.metar.load();
+        if (current == 0) return std::nullopt;
+    }
+    return std::nullopt;
+}
+
+uint32_t MetarCache::packIcao(std::string_view station)
+{
+    if (station.size() != 4) return 0;
+    uint32_t key = 0;
+    for (char c : station) key = (key << 8) | static_cast<uint8_t>(std::toupper(static_cast<unsigned char>(c)));
+    return key;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include "Seqlock.h"
+
+namespace rpc {
+    enum class FlightCategory : uint8_t {
+        UNKNOWN = 0,
+        VFR,
+        MVFR,
+        IFR,
+        LIFR
+    };
+
+    // METAR parsed once on reception into a compact fixed size record
+    struct Metar {
+        char station[5] = {};
+        int16_t windDirection = -1; // degrees, -1 when variable or missing
+        int16_t windSpeed = -1;     // knots
+        int16_t windGust = -1;
+        int16_t qnh = -1;           // hPa
+        int32_t visibility = -1;    // metres, 9999 for 10 km or more
+        int32_t ceiling = -1;       // feet, -1 when no BKN/OVC/VV layer
+        int8_t temperature = 0;
+        int8_t dewpoint = 0;
+        bool hasTemperature = false;
+        FlightCategory category = FlightCategory::UNKNOWN;
+        int64_t received = 0;       // unix seconds
+    };
+
+    // Returns false when the report does not look like a METAR
+    bool parseMetar(std::string_view report, Metar& metar);
+    // "Q1013, wind 250/12G22", empty when nothing useful was decoded
+    std::string formatMetar(const Metar& metar);
+
+    // Flat open addressing table of the latest METAR per station, fed by OnNewMetarReceived.
+    // Stations are keyed by their packed ICAO code; each record is replaced atomically through a
+    // seqlock so presence rendering reads it from any thread without parsing or locking.
+    class MetarCache
+    {
+    public:
+        static constexpr size_t CAPACITY = 1024; // stations, power of two
+
+        // Single writer. Returns false when the report could not be parsed or the table is full.
+        bool update(std::string_view station, std::string_view report, int64_t nowSeconds);
+        std::optional<Metar> find(std::string_view station) const;
+        size_t size() const { return size_.load(std::memory_order_relaxed); }
+
+    private:
+        static uint32_t packIcao(std::string_view station);
+
+        struct Slot {
+            std::atomic<uint32_t> key{ 0 };
+            Seqlock<Metar> metar;
+        };
+
+        std::array<Slot, CAPACITY> slots_;
+        std::atomic<size_t> size_{ 0 };
+    };
+} // namespace rpc
@@ -0,0 +1,64 @@
+#include "MovementCounters.h"
+#include <cstring>
+
+using namespace rpc;
+
+uint32_t MovementCounters::updateFlightPlan(PackedCallsign callsign, GroundState groundState, bool cleared)
+{
+    Aircraft* aircraft = aircraft_.tryEmplace(callsign).first;
+    if (!aircraft) return 0;
+    uint32_t movements = 0;
+    if (aircraft->seen) {
+        if (cleared && !aircraft->cleared) movements |= bit(Movement::CLEARANCE);
+        if (groundState != aircraft->groundState) {
+            switch (groundState) {
+            case GroundState::PUSH: movements |= bit(Movement::PUSHBACK); break;
+            case GroundState::TAXI: movements |= bit(Movement::TAXI_OUT); break;
+            case GroundState::TAXI_IN: movements |= bit(Movement::TAXI_IN); break;
+            default: break;
+            }
+        }
+    }
+    aircraft->seen = true;
+    aircraft->cleared = cleared;
+    aircraft->groundState = groundState;
+    return movements;
+}
+
+uint32_t MovementCounters::updateGroundSpeed(PackedCallsign callsign, int knots)
+{
+    Aircraft* aircraft = aircraft_.find(callsign);
+    if (!aircraft) return 0;
+    Airborne airborne = knots > AIRBORNE_SPEED ? Airborne::YES : knots < GROUND_SPEED ? Airborne::NO : aircraft->airborne;
+    if (airborne == aircraft->airborne) return 0;
+    Airborne before = aircraft->airborne;
+    aircraft->airborne = airborne;
+    if (before == Airborne::UNKNOWN) return 0;
+    return airborne == Airborne::YES ? bit(Movement::TAKEOFF) : bit(Movement::LANDING);
+}
+
+void MovementCounters::record(uint32_t movements, int64_t nowSeconds)
+{
+    for (size_t i = 0; i < rates_.size(); ++i) {
+        if (movements & (1u << i)) rates_[i].record(nowSeconds);
+    }
+}
+
+void MovementCounters::reset()
+{
+    aircraft_.clear();
+    for (auto& rate : rates_) rate.reset();
+}
+
+MovementCounters::GroundState MovementCounters::parseGroundState(const char* text)
+{
+    if (!text || !*text) return GroundState::NONE;
+    if (std::strcmp(text, "STUP") == 0) return GroundState::STARTUP;
+    if (std::strcmp(text, "PUSH") == 0) return GroundState::PUSH;
+    if (std::strcmp(text, "TAXI") == 0) return GroundState::TAXI;
+    if (std::strcmp(text, "DEPA") == 0) return GroundState::DEPARTURE;
+    if (std::strcmp(text, "ARR") == 0) return GroundState::ARRIVAL;
+    if (std::strcmp(text, "TAXIIN") == 0) return GroundState::TAXI_IN;
+    if (std::strcmp(text, "PARK") == 0) return GroundState::PARKED;
+    return GroundState::NONE;
+}
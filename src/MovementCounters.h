@@ -0,0 +1,84 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include "Callsign.h"
+#include "RateCounter.h"
+
+namespace rpc {
+    // Airport movements seen from flight plan events: clearances, pushbacks, taxis, takeoffs and
+    // landings. A small state machine per flight plan turns the ground state, the clearance flag
+    // and the ground speed into transitions, the caller keeps those at its own airport and records
+    // them. Nothing is scanned, each event touches one entry. Written by the EuroScope thread,
+    // rates readable from any thread.
+    class MovementCounters
+    {
+    public:
+        enum class Movement : uint8_t {
+            CLEARANCE = 0,
+            PUSHBACK,
+            TAXI_OUT,
+            TAXI_IN,
+            TAKEOFF,
+            LANDING,
+            COUNT
+        };
+
+        // EuroScope ground states, GetGroundState()
+        enum class GroundState : uint8_t {
+            NONE = 0,
+            STARTUP,   // STUP
+            PUSH,
+            TAXI,
+            DEPARTURE, // DEPA
+            ARRIVAL,   // ARR
+            TAXI_IN,   // TAXIIN
+            PARKED     // PARK
+        };
+
+        static constexpr int AIRBORNE_SPEED = 50; // knots, above is flying
+        static constexpr int GROUND_SPEED = 30;   // below is rolling out or taxiing, hysteresis in between
+
+        static constexpr uint32_t bit(Movement movement) { return 1u << static_cast<uint32_t>(movement); }
+        // Counted at the origin and at the destination, defined below the class that bit() needs complete
+        static const uint32_t DEPARTURE_MOVEMENTS;
+        static const uint32_t ARRIVAL_MOVEMENTS;
+
+        // Transitions completed by these events, as bit(Movement) flags. The first sight of a
+        // flight plan only sets its state: a plugin loaded mid session counts nothing it missed.
+        uint32_t updateFlightPlan(PackedCallsign callsign, GroundState groundState, bool cleared);
+        // Radar targets without flight plan data are ignored, they would never be removed
+        uint32_t updateGroundSpeed(PackedCallsign callsign, int knots);
+        void remove(PackedCallsign callsign) { aircraft_.erase(callsign); }
+
+        void record(uint32_t movements, int64_t nowSeconds);
+        // Over the last hour
+        uint32_t perHour(Movement movement, int64_t nowSeconds) const { return rates_[static_cast<size_t>(movement)].total(nowSeconds); }
+        void reset();
+
+        static GroundState parseGroundState(const char* text);
+
+    private:
+        enum class Airborne : uint8_t {
+            UNKNOWN = 0,
+            NO,
+            YES
+        };
+
+        struct Aircraft {
+            GroundState groundState = GroundState::NONE;
+            bool cleared = false;
+            bool seen = false; // flight plan data known
+            Airborne airborne = Airborne::UNKNOWN;
+        };
+
+    private:
+        CallsignMap<Aircraft> aircraft_{ 256 };
+        std::array<RateCounter<60>, static_cast<size_t>(Movement::COUNT)> rates_{
+            RateCounter<60>(60), RateCounter<60>(60), RateCounter<60>(60), RateCounter<60>(60), RateCounter<60>(60), RateCounter<60>(60)
+        };
+    };
+
+    inline constexpr uint32_t MovementCounters::DEPARTURE_MOVEMENTS = bit(Movement::CLEARANCE) | bit(Movement::PUSHBACK)
+        | bit(Movement::TAXI_OUT) | bit(Movement::TAKEOFF);
+    inline constexpr uint32_t MovementCounters::ARRIVAL_MOVEMENTS = bit(Movement::TAXI_IN) | bit(Movement::LANDING);
+} // namespace rpc
@@ -0,0 +1,62 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+enum State {
+    IDLE = 0,
+	CONTROLLING,
+	OBSERVING,
+    SWEATBOX,
+    PLAYBACK
+};
+
+enum Tier {
+    NONE = 0,
+    SILVER,
+    GOLD
+};
+
+namespace rpc {
+    constexpr size_t CACHE_LINE_SIZE = 64;
+
+    // What made the presence stale, latency is accounted per cause
+    enum class ChangeCause : int32_t {
+        TRACK_CHANGE = 0,
+        CONNECTION_CHANGE,
+        IDLE_ROTATION,
+        COUNT
+    };
+
+    // Everything the presence renderer needs from the EuroScope thread. Plain fixed size data so
+    // the whole block is published at once through a Seqlock; the renderer never sees half of an
+    // update nor a string being reallocated under it.
+    struct PluginState {
+        int32_t connectionType = 0; // State enum
+        int32_t tier = 0;           // Tier enum
+        int32_t facility = 0;       // GetFacility() of my position, 0 when not controlling
+        int32_t onlineTime = 0;     // hours
+        bool isOnFire = false;
+        uint32_t totalTracks = 0;
+        uint32_t totalAircrafts = 0;
+        uint32_t aircraftTracked = 0;
+        uint32_t changeSequence = 0; // bumped for every change whose latency is measured
+        int32_t changeCause = 0;     // ChangeCause
+        uint64_t changedNs = 0;      // steady clock of the event behind the change
+        char callsign[16] = {};
+        char frequency[12] = {};
+        char runways[24] = {};       // active at the airport of my callsign, "27L/26R"
+        char idlingText[64] = {};
+        char badge[32] = {};         // title of the last badge unlocked this session
+
+        // Truncating copy, the destination stays null terminated
+        template <size_t N>
+        static void copy(char (&destination)[N], std::string_view source)
+        {
+            size_t length = source.size() < N - 1 ? source.size() : N - 1;
+            std::memcpy(destination, source.data(), length);
+            std::memset(destination + length, 0, N - length);
+        }
+    };
+} // namespace rpc
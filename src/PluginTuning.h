@@ -0,0 +1,28 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "PluginState.h"
+
+namespace rpc {
+    // Thresholds and cadences of the plugin's state machine. The replay includes this header too,
+    // so an offline run uses the values the plugin ships with.
+    constexpr double ONFIRE_THRESHOLD = 10.0; // workload score, roughly "aircraft tracked" equivalent
+    constexpr double ONFIRE_RELEASE_THRESHOLD = 7.0;
+    constexpr int64_t HOUR_THRESHOLD = 7200; // 2 hour
+    constexpr double NEARBY_ATC_RANGE = 150.0; // nm, used when my own range is unknown
+    constexpr int64_t TARGET_TIMEOUT = 60; // seconds without position update before a target is dropped
+    constexpr int64_t TARGET_EXPIRY_INTERVAL = 30;
+    constexpr size_t DISCORD_UPDATE_LIMIT = 5; // Discord accepts 5 presence updates per 20 seconds
+    constexpr uint64_t DISCORD_UPDATE_WINDOW_NS = 20000000000;
+    constexpr int64_t DATA_INTERVAL_MIN = 1; // seconds between SDK polls, adapted to how fast the picture changes
+    constexpr int64_t DATA_INTERVAL_MAX = 8;
+    constexpr int64_t DATA_INTERVAL_INITIAL = 4;
+
+    // Tier shown for the time online, in seconds
+    inline int32_t tierFor(int64_t onlineSeconds)
+    {
+        if (onlineSeconds > 2 * HOUR_THRESHOLD) return Tier::GOLD;
+        if (onlineSeconds > HOUR_THRESHOLD) return Tier::SILVER;
+        return Tier::NONE;
+    }
+} // namespace rpc
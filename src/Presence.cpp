@@ -0,0 +1,115 @@
+#include "Presence.h"
+#include <algorithm>
+
+using namespace rpc;
+
+void rpc::appendSegment(std::string& text, const std::string& segment)
+{
+    if (text.size() + 3 + segment.size() > DISCORD_TEXT_LIMIT) return;
+    text += " | " + segment;
+}
+
+namespace {
+    // What a delivery, ground or tower position shows instead of the tracked count, empty for others
+    std::string movementText(const PresenceInput& input)
+    {
+        auto perHour = [&input](MovementCounters::Movement movement) {
+            return std::to_string(input.movementsPerHour[static_cast<size_t>(movement)]) + "/h";
+        };
+        using Movement = MovementCounters::Movement;
+        switch (input.state.facility) {
+        case FACILITY_DEL:
+            return "Clearances: " + perHour(Movement::CLEARANCE);
+        case FACILITY_GND:
+            return "Pushbacks: " + perHour(Movement::PUSHBACK) + " | Taxi out: " + perHour(Movement::TAXI_OUT) + " | Taxi in: " + perHour(Movement::TAXI_IN);
+        case FACILITY_TWR:
+            return "Departures: " + perHour(Movement::TAKEOFF) + " | Arrivals: " + perHour(Movement::LANDING);
+        default:
+            return "";
+        }
+    }
+}
+
+PresenceFrame rpc::formatPresence(const PresenceInput& input)
+{
+    const PluginState& current = input.state;
+    PresenceFrame frame;
+    frame.details = current.idlingText;
+    frame.state = "Idling";
+
+    switch (current.connectionType) {
+    case State::CONTROLLING:
+        frame.details = "Controlling " + std::string(current.callsign) + " " + current.frequency;
+        frame.state = movementText(input);
+        if (frame.state.empty())
+            frame.state = "Aircraft tracked: " + std::to_string(current.aircraftTracked) + " of " + std::to_string(current.totalAircrafts);
+        if (input.inboundSoon > 0)
+            frame.state += " | " + std::to_string(input.inboundSoon) + " inbound in " + std::to_string(FORECAST_MINUTES) + " min";
+        frame.smallImageKey = "radarlogo";
+        break;
+    case State::OBSERVING:
+        frame.details = "Observing as " + std::string(current.callsign);
+        frame.state = "Aircraft in range: " + std::to_string(input.aircraftInRange);
+        break;
+    case State::SWEATBOX:
+        frame.details = "In Sweatbox";
+        frame.state = "Aircraft tracked: (" + std::to_string(current.aircraftTracked) + " of " + std::to_string(current.totalAircrafts) + ")";
+        frame.smallImageKey = "radarlogo";
+        break;
+    case State::PLAYBACK:
+        frame.details = "In Playback";
+        frame.state = "Aircraft in range: " + std::to_string(input.aircraftInRange);
+        break;
+    default:
+        break;
+    }
+
+    // Positions controlled from other EuroScope instances of this machine
+    const SharedPresence::Merged& merged = input.merged;
+    if (merged.controlling > 1 || (merged.controlling == 1 && current.connectionType != State::CONTROLLING)) {
+        frame.details = "Controlling " + merged.callsigns;
+        frame.state = "Aircraft tracked: " + std::to_string(merged.tracked) + " of " + std::to_string(std::max(merged.total, current.totalAircrafts));
+        frame.smallImageKey = "radarlogo";
+    }
+
+    switch (current.tier) {
+        case Tier::SILVER:
+            frame.largeImageKey = "silver";
+            frame.largeImageText = "On a " + std::to_string(current.onlineTime) + " hour streak";
+            break;
+        case Tier::GOLD:
+            frame.largeImageKey = "gold";
+            frame.largeImageText = "On a " + std::to_string(current.onlineTime) + " hour streak";
+			break;
+        case Tier::NONE:
+        default:
+            frame.largeImageKey = "main";
+            frame.largeImageText = "French VACC";
+			break;
+    }
+
+    if (current.isOnFire) {
+        frame.largeImageKey += "fire";
+        if (!frame.largeImageText.empty()) frame.largeImageText += " ";
+        frame.largeImageText += "On Fire!";
+	}
+    if (current.badge[0] != '\0') appendSegment(frame.largeImageText, current.badge);
+
+    frame.smallImageText = "Total Tracks: " + std::to_string(current.totalTracks);
+    if (current.connectionType == State::CONTROLLING || current.connectionType == State::SWEATBOX) {
+        if (input.handoffsIn + input.handoffsOut > 0)
+            appendSegment(frame.smallImageText, "Handoffs: " + std::to_string(input.handoffsIn) + " in / " + std::to_string(input.handoffsOut) + " out");
+        if (input.transmissions > 0)
+            appendSegment(frame.smallImageText, std::to_string(input.transmissions) + " transmissions");
+        if (input.messagesPerMinute > 0)
+            appendSegment(frame.smallImageText, std::to_string(input.messagesPerMinute) + " msgs/min");
+    }
+    if (current.connectionType == State::CONTROLLING || current.connectionType == State::OBSERVING) {
+        if (input.nearbyControllers > 0)
+            appendSegment(frame.smallImageText, std::to_string(input.nearbyControllers) + " ATC online nearby");
+    }
+    if (current.connectionType == State::CONTROLLING && !input.weather.empty())
+        appendSegment(frame.smallImageText, input.weather);
+
+    return frame;
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <string>
+#include "MovementCounters.h"
+#include "PluginState.h"
+#include "SharedPresence.h"
+
+namespace rpc {
+    constexpr int FORECAST_MINUTES = 10; // "N inbound" horizon shown in the presence
+    constexpr size_t DISCORD_TEXT_LIMIT = 127; // Discord rejects presence fields of 128 characters or more
+    constexpr int FACILITY_DEL = 2; // GetFacility() codes of the positions shown with movements
+    constexpr int FACILITY_GND = 3;
+    constexpr int FACILITY_TWR = 4;
+
+    // Everything a presence frame is rendered from, gathered by the plugin or the replay tool
+    struct PresenceInput {
+        PluginState state;
+        uint32_t inboundSoon = 0;     // sector entries within FORECAST_MINUTES
+        uint32_t aircraftInRange = 0;
+        uint32_t handoffsIn = 0;
+        uint32_t handoffsOut = 0;
+        uint64_t transmissions = 0;
+        int messagesPerMinute = 0;
+        uint32_t nearbyControllers = 0;
+        std::array<uint32_t, static_cast<size_t>(MovementCounters::Movement::COUNT)> movementsPerHour{}; // at my airport
+        std::string weather;          // "LFPG 27L/26R Q1013, wind 250/12", empty when unknown
+        SharedPresence::Merged merged; // positions of the other EuroScope instances
+    };
+
+    struct PresenceFrame {
+        std::string details;
+        std::string state;
+        std::string largeImageKey;
+        std::string largeImageText;
+        std::string smallImageKey;
+        std::string smallImageText;
+
+        bool operator==(const PresenceFrame&) const = default;
+    };
+
+    // Pure text rendering of the Discord presence, no SDK nor Discord dependency
+    PresenceFrame formatPresence(const PresenceInput& input);
+
+    // Adds " | segment" unless it would push the text over the Discord field limit
+    void appendSegment(std::string& text, const std::string& segment);
+} // namespace rpc
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+#include "AdaptiveInterval.h"
+
+namespace rpc {
+    constexpr int64_t PRESENCE_INTERVAL_MIN_MS = 1000; // presence thread wakeups, adapted to how fast the presence changes
+    constexpr int64_t PRESENCE_INTERVAL_MAX_MS = 8000;
+    constexpr int64_t PRESENCE_PARKED = -1; // wait until woken
+
+    // How long the presence thread sleeps after a pass. The plugin's thread and the replay both
+    // run this, so the wakeups measured offline are the ones the plugin makes. The shared segment
+    // heartbeat does not depend on it, OnTimer refreshes it.
+    class PresenceCadence
+    {
+    public:
+        // settled: the pass had nothing new to send; woken: a transition cut the wait short;
+        // idle: disconnected; instances: live EuroScope instances sharing the presence
+        int64_t next(bool settled, bool woken, bool idle, uint32_t instances)
+        {
+            int64_t interval = interval_.update(!settled || woken);
+            // The leader renders the others' snapshots, which change without waking it
+            if (instances > 1) return PRESENCE_INTERVAL_MIN_MS;
+            if (settled && idle) return PRESENCE_PARKED;
+            return interval;
+        }
+
+    private:
+        AdaptiveInterval interval_{ PRESENCE_INTERVAL_MIN_MS, PRESENCE_INTERVAL_MAX_MS, PRESENCE_INTERVAL_MIN_MS };
+    };
+} // namespace rpc
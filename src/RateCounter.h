@@ -0,0 +1,65 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace rpc {
+    // Sliding window event counter over a ring of time buckets. Buckets are stamped with the absolute
+    // bucket number they hold and recycled lazily, so recording is O(1) and needs no timer. One writer,
+    // readers on any thread.
+    template <size_t BUCKETS>
+    class RateCounter
+    {
+    public:
+        explicit RateCounter(int64_t bucketSeconds) : bucketSeconds_(bucketSeconds) {}
+
+        void record(int64_t nowSeconds, uint32_t count = 1)
+        {
+            int64_t stamp = nowSeconds / bucketSeconds_;
+            Bucket& bucket = buckets_[static_cast<size_t>(stamp) % BUCKETS];
+            if (bucket.stamp.load(std::memory_order_relaxed) != stamp) {
+                bucket.count.store(0, std::memory_order_relaxed);
+                bucket.stamp.store(stamp, std::memory_order_release);
+            }
+            bucket.count.fetch_add(count, std::memory_order_relaxed);
+        }
+
+        // Events within the whole window ending now, O(BUCKETS)
+        uint32_t total(int64_t nowSeconds) const
+        {
+            int64_t newest = nowSeconds / bucketSeconds_;
+            uint32_t sum = 0;
+            for (const Bucket& bucket : buckets_) {
+                int64_t stamp = bucket.stamp.load(std::memory_order_acquire);
+                if (stamp > newest - static_cast<int64_t>(BUCKETS) && stamp <= newest)
+                    sum += bucket.count.load(std::memory_order_relaxed);
+            }
+            return sum;
+        }
+
+        // Average events per minute over the window
+        double perMinute(int64_t nowSeconds) const
+        {
+            return total(nowSeconds) * 60.0 / static_cast<double>(windowSeconds());
+        }
+
+        int64_t windowSeconds() const { return bucketSeconds_ * static_cast<int64_t>(BUCKETS); }
+
+        void reset()
+        {
+            for (Bucket& bucket : buckets_) {
+                bucket.stamp = -1;
+                bucket.count = 0;
+            }
+        }
+
+    private:
+        struct Bucket {
+            std::atomic<int64_t> stamp{ -1 };
+            std::atomic<uint32_t> count{ 0 };
+        };
+
+        int64_t bucketSeconds_;
+        std::array<Bucket, BUCKETS> buckets_;
+    };
+} // namespace rpc
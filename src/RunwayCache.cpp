@@ -0,0 +1,42 @@
+#include "RunwayCache.h"
+#include <cstring>
+
+using namespace rpc;
+
+void RunwayCache::add(std::string_view airport, std::string_view runway)
+{
+    if (runway.empty()) return;
+    std::string_view icao = icaoOf(airport);
+    Entry* entry = airports_.tryEmplace(packCallsign(icao.data(), icao.size())).first;
+    if (!entry) return;
+
+    // Already listed, as a whole slash separated item
+    std::string_view text(entry->text);
+    for (size_t start = 0; start < text.size();) {
+        size_t end = text.find('/', start);
+        if (end == std::string_view::npos) end = text.size();
+        if (text.substr(start, end - start) == runway) return;
+        start = end + 1;
+    }
+
+    size_t length = text.size();
+    size_t needed = (length ? 1 : 0) + runway.size();
+    if (length + needed >= TEXT_SIZE) return;
+    if (length) entry->text[length++] = '/';
+    std::memcpy(entry->text + length, runway.data(), runway.size());
+    entry->text[length + runway.size()] = '\0';
+}
+
+const char* RunwayCache::find(std::string_view airport) const
+{
+    const Entry* entry = airports_.find(packCallsign(airport.data(), airport.size()));
+    return entry && entry->text[0] ? entry->text : nullptr;
+}
+
+std::string_view RunwayCache::icaoOf(std::string_view airportName)
+{
+    size_t start = airportName.find_first_not_of(' ');
+    if (start == std::string_view::npos) return {};
+    airportName.remove_prefix(start);
+    return airportName.substr(0, airportName.find(' '));
+}
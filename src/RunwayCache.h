@@ -0,0 +1,33 @@
+#pragma once
+#include <cstddef>
+#include <string_view>
+#include "Callsign.h"
+
+namespace rpc {
+    // Active runways per airport, "27L/26R", rebuilt from the sector file runway elements only
+    // when EuroScope reports a runway activity change. Lookups are one probe into the table keyed
+    // by the packed ICAO code. EuroScope thread only.
+    class RunwayCache
+    {
+    public:
+        static constexpr size_t TEXT_SIZE = 24; // four parallel runways, longer lists are cut
+
+        void clear() { airports_.clear(); }
+        // Runways of an airport in sector file order, a runway active both ways is listed once
+        void add(std::string_view airport, std::string_view runway);
+
+        // nullptr when the airport has no active runway
+        const char* find(std::string_view airport) const;
+        size_t size() const { return airports_.size(); }
+
+        // Sector file airport names may carry more than the ICAO code: "LFPG Paris" -> "LFPG"
+        static std::string_view icaoOf(std::string_view airportName);
+
+    private:
+        struct Entry {
+            char text[TEXT_SIZE] = {};
+        };
+
+        CallsignMap<Entry> airports_{ 64 };
+    };
+} // namespace rpc
@@ -0,0 +1,93 @@
+#include "SectorForecast.h"
+#include <algorithm>
+
+using namespace rpc;
+
+void SectorForecast::update(PackedCallsign flightPlan, int entryMinutes, int exitMinutes, int64_t nowMinute)
+{
+    Prediction next;
+    next.entryMinute = toAbsolute(entryMinutes, false, nowMinute); // 0 means already inside
+    next.exitMinute = toAbsolute(exitMinutes, true, nowMinute);
+
+    Prediction* current = predictions_.find(flightPlan);
+    if (!current) {
+        if (next.entryMinute < 0 && next.exitMinute < 0) return;
+        current = predictions_.tryEmplace(flightPlan).first;
+    }
+
+    if (current->entryMinute != next.entryMinute) {
+        subtract(entries_, current->entryMinute);
+        add(entries_, next.entryMinute);
+    }
+    if (current->exitMinute != next.exitMinute) {
+        subtract(exits_, current->exitMinute);
+        add(exits_, next.exitMinute);
+    }
+
+    if (next.entryMinute < 0 && next.exitMinute < 0) predictions_.erase(flightPlan);
+    else *current = next;
+}
+
+void SectorForecast::remove(PackedCallsign flightPlan)
+{
+    Prediction* current = predictions_.find(flightPlan);
+    if (!current) return;
+    subtract(entries_, current->entryMinute);
+    subtract(exits_, current->exitMinute);
+    predictions_.erase(flightPlan);
+}
+
+void SectorForecast::reset()
+{
+    predictions_.clear();
+    for (Bucket& bucket : entries_) { bucket.minute = -1; bucket.count = 0; }
+    for (Bucket& bucket : exits_) { bucket.minute = -1; bucket.count = 0; }
+}
+
+uint32_t SectorForecast::inboundWithin(int minutes, int64_t nowMinute) const
+{
+    return sum(entries_, minutes, nowMinute);
+}
+
+uint32_t SectorForecast::outboundWithin(int minutes, int64_t nowMinute) const
+{
+    return sum(exits_, minutes, nowMinute);
+}
+
+int64_t SectorForecast::toAbsolute(int minutes, bool allowNow, int64_t nowMinute)
+{
+    if (minutes < 0 || (minutes == 0 && !allowNow) || minutes >= HORIZON_MINUTES) return -1;
+    return nowMinute + minutes;
+}
+
+void SectorForecast::add(Ring& ring, int64_t minute)
+{
+    if (minute < 0) return;
+    Bucket& bucket = ring[static_cast<size_t>(minute) & (HORIZON_MINUTES - 1)];
+    if (bucket.minute.load(std::memory_order_relaxed) != minute) {
+        // Bucket still holds an expired minute, recycle it
+        bucket.count.store(0, std::memory_order_relaxed);
+        bucket.minute.store(minute, std::memory_order_release);
+    }
+    bucket.count.fetch_add(1, std::memory_order_relaxed);
+}
+
+void SectorForecast::subtract(Ring& ring, int64_t minute)
+{
+    if (minute < 0) return;
+    Bucket& bucket = ring[static_cast<size_t>(minute) & (HORIZON_MINUTES - 1)];
+    if (bucket.minute.load(std::memory_order_relaxed) == minute && bucket.count.load(std::memory_order_relaxed) > 0)
+        bucket.count.fetch_sub(1, std::memory_order_relaxed);
+}
+
+uint32_t SectorForecast::sum(const Ring& ring, int minutes, int64_t nowMinute)
+{
+    minutes = std::clamp(minutes, 0, HORIZON_MINUTES - 1);
+    uint32_t total = 0;
+    for (int64_t minute = nowMinute; minute <= nowMinute + minutes; ++minute) {
+        const Bucket& bucket = ring[static_cast<size_t>(minute) & (HORIZON_MINUTES - 1)];
+        if (bucket.minute.load(std::memory_order_acquire) == minute)
+            total += bucket.count.load(std::memory_order_relaxed);
+    }
+    return total;
+}
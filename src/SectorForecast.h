@@ -0,0 +1,47 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include "Callsign.h"
+
+namespace rpc {
+    // Time bucketed ring of predicted sector entries and exits.
+    // Flight plans are only re-bucketed when their own updates arrive, buckets are stamped with
+    // the absolute minute they hold so expired buckets are recycled lazily without any sweep.
+    class SectorForecast
+    {
+    public:
+        static constexpr int HORIZON_MINUTES = 64; // power of two, longer predictions are ignored
+
+        // entryMinutes / exitMinutes as returned by the SDK (-1 when never entering)
+        void update(PackedCallsign flightPlan, int entryMinutes, int exitMinutes, int64_t nowMinute);
+        void remove(PackedCallsign flightPlan);
+        void reset();
+
+        // Number of flight plans entering / leaving my sectors within the next minutes (O(minutes)), any thread
+        uint32_t inboundWithin(int minutes, int64_t nowMinute) const;
+        uint32_t outboundWithin(int minutes, int64_t nowMinute) const;
+
+    private:
+        struct Prediction {
+            int64_t entryMinute = -1;
+            int64_t exitMinute = -1;
+        };
+
+        struct Bucket {
+            std::atomic<int64_t> minute{ -1 };
+            std::atomic<uint32_t> count{ 0 };
+        };
+        using Ring = std::array<Bucket, HORIZON_MINUTES>;
+
+        static int64_t toAbsolute(int minutes, bool allowNow, int64_t nowMinute);
+        static void add(Ring& ring, int64_t minute);
+        static void subtract(Ring& ring, int64_t minute);
+        static uint32_t sum(const Ring& ring, int minutes, int64_t nowMinute);
+
+    private:
+        CallsignMap<Prediction> predictions_{ 256 };
+        Ring entries_;
+        Ring exits_;
+    };
+} // namespace rpc
@@ -0,0 +1,70 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace rpc {
+    // Single writer sequence lock for small trivially copyable values. The payload is stored in
+    // relaxed atomic words so concurrent copies are race free; readers retry on a torn copy and
+    // never block the writer.
+    template <typename T>
+    class Seqlock
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Seqlock payload must be trivially copyable");
+
+    public:
+        Seqlock() { store(T{}); }
+
+        void store(const T& value)
+        {
+            std::array<uint64_t, WORDS> words{};
+            std::memcpy(words.data(), &value, sizeof(T));
+
+            // Odd only when the previous writer died mid store, possible when the lock lives in memory
+            // shared between processes; the next store starts from the even value below it
+            uint64_t sequence = sequence_.load(std::memory_order_relaxed) & ~uint64_t{ 1 };
+            sequence_.store(sequence + 1, std::memory_order_relaxed); // odd: write in progress
+            std::atomic_thread_fence(std::memory_order_release);
+            for (size_t i = 0; i < WORDS; ++i) words_[i].store(words[i], std::memory_order_relaxed);
+            sequence_.store(sequence + 2, std::memory_order_release);
+        }
+
+        T load() const
+        {
+            T value;
+            while (!tryLoad(value)) {}
+            return value;
+        }
+
+        // Bounded retries, for a writer in another process that may stop without finishing its store
+        bool tryLoad(T& value, int attempts) const
+        {
+            for (int i = 0; i < attempts; ++i)
+                if (tryLoad(value)) return true;
+            return false;
+        }
+
+        // Single attempt, false when a write was in progress
+        bool tryLoad(T& value) const
+        {
+            std::array<uint64_t, WORDS> words;
+            uint64_t before = sequence_.load(std::memory_order_acquire);
+            if (before & 1) return false;
+            for (size_t i = 0; i < WORDS; ++i) words[i] = words_[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence_.load(std::memory_order_relaxed) != before) return false;
+            std::memcpy(static_cast<void*>(&value), words.data(), sizeof(T));
+            return true;
+        }
+
+        uint64_t version() const { return sequence_.load(std::memory_order_acquire); }
+
+    private:
+        static constexpr size_t WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+        std::atomic<uint64_t> sequence_{ 0 };
+        std::array<std::atomic<uint64_t>, WORDS> words_{};
+    };
+} // namespace rpc
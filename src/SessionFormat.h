@@ -0,0 +1,95 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Session recording file format, shared by the recorder and the offline tools.
+//
+// File: FileHeader, then records. Every record starts with its RecordType byte; all but
+// DEFINE_CALLSIGN continue with the milliseconds elapsed since the previous record (varint)
+// and the interned callsign id (varint) when the record has one. Positions, altitudes, speeds
+// and sector minutes are zigzag varint deltas against the previous record of the same callsign,
+// starting from 0 (sector minutes from -1, "unknown").
+//
+//     DEFINE_CALLSIGN         id, length byte, characters
+//     RADAR_POSITION          id, dlat, dlon, daltitude, dgroundspeed
+//     FLIGHT_PLAN_DATA        id, dentry, dexit
+//     CONTROLLER_ASSIGNED     id, data type, flags byte
+//     CONTROLLER_POSITION     id, flags byte, facility, rating, frequency kHz, dlat, dlon, range
+//     FLIGHT_PLAN_DISCONNECT  id
+//     CONTROLLER_DISCONNECT   id
+//     CONNECTION_TYPE         State
+namespace rpc::session {
+    constexpr uint32_t FILE_MAGIC = 0x53525345; // "ESRS"
+    constexpr uint32_t FILE_VERSION = 1;
+    constexpr double COORDINATE_SCALE = 100000.0; // 1e-5 degree, about a metre
+
+    struct FileHeader {
+        uint32_t magic;
+        uint32_t version;
+        int64_t startMs; // unix milliseconds, base of the first record delta
+    };
+
+    enum class RecordType : uint8_t {
+        DEFINE_CALLSIGN = 1,
+        RADAR_POSITION,
+        FLIGHT_PLAN_DATA,
+        CONTROLLER_ASSIGNED,
+        CONTROLLER_POSITION,
+        FLIGHT_PLAN_DISCONNECT,
+        CONTROLLER_DISCONNECT,
+        CONNECTION_TYPE
+    };
+
+    enum Flags : uint8_t {
+        TRACKING_IS_ME = 1 << 0,
+        HANDOFF_PENDING = 1 << 1,
+        HANDOFF_TARGET_IS_ME = 1 << 2,
+        IS_SELF = 1 << 3,       // CONTROLLER_POSITION of ControllerMyself()
+        IS_CONTROLLER = 1 << 4, // CONTROLLER_POSITION of a controlling position, not an observer
+        IS_INSTRUCTION = 1 << 5 // CONTROLLER_ASSIGNED data type counted as an instruction by the workload
+    };
+
+    // One SDK callback as captured on EuroScope's thread, fields unused by the type stay zero
+    struct Event {
+        int64_t timeMs = 0; // unix milliseconds
+        RecordType type = RecordType::CONNECTION_TYPE;
+        uint8_t flags = 0;
+        char callsign[16] = {};
+        int32_t latitude = 0;     // COORDINATE_SCALE units
+        int32_t longitude = 0;
+        int32_t altitude = 0;     // feet
+        int32_t groundSpeed = 0;  // knots
+        int32_t code = 0;         // CTR_DATA_TYPE for CONTROLLER_ASSIGNED, State for CONNECTION_TYPE
+        int32_t entryMinutes = -1;
+        int32_t exitMinutes = -1;
+        int32_t facility = 0;
+        int32_t rating = 0;
+        int32_t frequencyKhz = 0;
+        int32_t range = 0;        // nm
+    };
+
+    inline size_t putVarint(uint8_t* out, uint64_t value)
+    {
+        size_t size = 0;
+        while (value >= 0x80) {
+            out[size++] = static_cast<uint8_t>(value) | 0x80;
+            value >>= 7;
+        }
+        out[size++] = static_cast<uint8_t>(value);
+        return size;
+    }
+
+    // Returns the bytes consumed, 0 when the input ends inside the varint
+    inline size_t getVarint(const uint8_t* in, size_t available, uint64_t& value)
+    {
+        value = 0;
+        for (size_t i = 0; i < available && i < 10; ++i) {
+            value |= static_cast<uint64_t>(in[i] & 0x7f) << (7 * i);
+            if ((in[i] & 0x80) == 0) return i + 1;
+        }
+        return 0;
+    }
+
+    inline uint64_t zigzag(int64_t value) { return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63); }
+    inline int64_t unzigzag(uint64_t value) { return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1); }
+} // namespace rpc::session
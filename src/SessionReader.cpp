@@ -0,0 +1,125 @@
+#include "SessionReader.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace rpc;
+using namespace rpc::session;
+
+SessionReader::SessionReader(const uint8_t* data, size_t size) : data_(data), size_(size)
+{
+    FileHeader header;
+    if (size_ < sizeof(header)) return;
+    std::memcpy(&header, data_, sizeof(header));
+    if (header.magic != FILE_MAGIC || header.version != FILE_VERSION) return;
+
+    valid_ = true;
+    startMs_ = timeMs_ = header.startMs;
+    offset_ = sizeof(header);
+}
+
+bool SessionReader::next(Event& event)
+{
+    if (!valid_ || corrupt_) return false;
+
+    while (offset_ < size_) {
+        uint8_t tag = data_[offset_++];
+        RecordType type = static_cast<RecordType>(tag);
+
+        if (type == RecordType::DEFINE_CALLSIGN) {
+            uint64_t id;
+            uint8_t length;
+            if (!readVarint(id) || id != callsigns_.size() || !readByte(length) || size_ - offset_ < length) return fail();
+            callsigns_.emplace_back(reinterpret_cast<const char*>(data_ + offset_), length);
+            last_.emplace_back();
+            offset_ += length;
+            continue;
+        }
+        if (tag < static_cast<uint8_t>(RecordType::RADAR_POSITION) || tag > static_cast<uint8_t>(RecordType::CONNECTION_TYPE)) return fail();
+
+        uint64_t elapsed;
+        if (!readVarint(elapsed)) return fail();
+        timeMs_ += static_cast<int64_t>(elapsed);
+
+        event = Event{};
+        event.type = type;
+        event.timeMs = timeMs_;
+
+        Last unused;
+        Last* last = &unused;
+        if (type != RecordType::CONNECTION_TYPE) {
+            uint64_t id;
+            if (!readVarint(id) || id >= callsigns_.size()) return fail();
+            const std::string& callsign = callsigns_[id];
+            std::memcpy(event.callsign, callsign.data(), std::min(callsign.size(), sizeof(event.callsign) - 1));
+            last = &last_[id];
+        }
+
+        uint64_t value;
+        switch (type) {
+        case RecordType::RADAR_POSITION:
+            if (!readDelta(last->latitude) || !readDelta(last->longitude) || !readDelta(last->altitude) || !readDelta(last->groundSpeed)) return fail();
+            event.latitude = last->latitude;
+            event.longitude = last->longitude;
+            event.altitude = last->altitude;
+            event.groundSpeed = last->groundSpeed;
+            break;
+        case RecordType::FLIGHT_PLAN_DATA:
+            if (!readDelta(last->entryMinutes) || !readDelta(last->exitMinutes)) return fail();
+            event.entryMinutes = last->entryMinutes;
+            event.exitMinutes = last->exitMinutes;
+            break;
+        case RecordType::CONTROLLER_ASSIGNED:
+            if (!readVarint(value) || !readByte(event.flags)) return fail();
+            event.code = static_cast<int32_t>(value);
+            break;
+        case RecordType::CONTROLLER_POSITION: {
+            uint64_t facility, rating, frequency, range;
+            if (!readByte(event.flags) || !readVarint(facility) || !readVarint(rating) || !readVarint(frequency)
+                || !readDelta(last->latitude) || !readDelta(last->longitude) || !readVarint(range)) return fail();
+            event.facility = static_cast<int32_t>(facility);
+            event.rating = static_cast<int32_t>(rating);
+            event.frequencyKhz = static_cast<int32_t>(frequency);
+            event.latitude = last->latitude;
+            event.longitude = last->longitude;
+            event.range = static_cast<int32_t>(range);
+            break;
+        }
+        case RecordType::CONNECTION_TYPE:
+            if (!readVarint(value)) return fail();
+            event.code = static_cast<int32_t>(value);
+            break;
+        default:
+            break;
+        }
+        return true;
+    }
+    return false;
+}
+
+bool SessionReader::readVarint(uint64_t& value)
+{
+    size_t consumed = getVarint(data_ + offset_, size_ - offset_, value);
+    offset_ += consumed;
+    return consumed != 0;
+}
+
+bool SessionReader::readDelta(int32_t& last)
+{
+    uint64_t value;
+    if (!readVarint(value)) return false;
+    last = static_cast<int32_t>(last + unzigzag(value));
+    return true;
+}
+
+bool SessionReader::readByte(uint8_t& value)
+{
+    if (offset_ >= size_) return false;
+    value = data_[offset_++];
+    return true;
+}
+
+bool SessionReader::fail()
+{
+    corrupt_ = true;
+    return false;
+}
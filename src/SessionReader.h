@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "SessionFormat.h"
+
+namespace rpc {
+    // Decodes a session recording held in memory, typically a mapped file, one event at a time
+    class SessionReader
+    {
+    public:
+        SessionReader(const uint8_t* data, size_t size);
+
+        // False when the header is missing, has the wrong magic or an unsupported version
+        bool isValid() const { return valid_; }
+        int64_t getStartMs() const { return startMs_; }
+
+        // Fills event with the next record, false at the end or on a truncated/corrupt record
+        bool next(session::Event& event);
+        bool isCorrupt() const { return corrupt_; }
+        size_t getOffset() const { return offset_; }
+        size_t getCallsignCount() const { return callsigns_.size(); }
+
+    private:
+        struct Last {
+            int32_t latitude = 0;
+            int32_t longitude = 0;
+            int32_t altitude = 0;
+            int32_t groundSpeed = 0;
+            int32_t entryMinutes = -1;
+            int32_t exitMinutes = -1;
+        };
+
+        bool readVarint(uint64_t& value);
+        bool readDelta(int32_t& last);
+        bool readByte(uint8_t& value);
+        bool fail();
+
+    private:
+        const uint8_t* data_;
+        size_t size_;
+        size_t offset_ = 0;
+        bool valid_ = false;
+        bool corrupt_ = false;
+        int64_t startMs_ = 0;
+        int64_t timeMs_ = 0;
+        std::vector<std::string> callsigns_;
+        std::vector<Last> last_;
+    };
+} // namespace rpc
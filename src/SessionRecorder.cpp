@@ -0,0 +1,168 @@
+#include "SessionRecorder.h"
+#include <chrono>
+#include <cstring>
+
+using namespace rpc;
+using namespace rpc::session;
+
+namespace {
+    void putVarint(std::vector<uint8_t>& out, uint64_t value)
+    {
+        uint8_t bytes[10];
+        out.insert(out.end(), bytes, bytes + session::putVarint(bytes, value));
+    }
+
+    void putDelta(std::vector<uint8_t>& out, int32_t value, int32_t& last)
+    {
+        putVarint(out, zigzag(static_cast<int64_t>(value) - last));
+        last = value;
+    }
+
+    bool hasCallsign(RecordType type)
+    {
+        return type != RecordType::CONNECTION_TYPE && type != RecordType::DEFINE_CALLSIGN;
+    }
+}
+
+uint32_t SessionEncoder::intern(const char* callsign, std::vector<uint8_t>& out)
+{
+    const void* terminator = std::memchr(callsign, '\0', sizeof(Event::callsign));
+    size_t length = terminator ? static_cast<const char*>(terminator) - callsign : sizeof(Event::callsign);
+    auto [it, inserted] = ids_.try_emplace(std::string(callsign, length), static_cast<uint32_t>(ids_.size()));
+    if (inserted) {
+        last_.emplace_back();
+        out.push_back(static_cast<uint8_t>(RecordType::DEFINE_CALLSIGN));
+        putVarint(out, it->second);
+        out.push_back(static_cast<uint8_t>(length));
+        out.insert(out.end(), callsign, callsign + length);
+    }
+    return it->second;
+}
+
+void SessionEncoder::encode(const Event& event, std::vector<uint8_t>& out)
+{
+    uint32_t id = hasCallsign(event.type) ? intern(event.callsign, out) : 0;
+    if (event.type == RecordType::FLIGHT_PLAN_DATA) {
+        Last& last = last_[id];
+        int64_t minute = event.timeMs / 60000;
+        if (event.entryMinutes == last.entryMinutes && event.exitMinutes == last.exitMinutes && minute == last.forecastMinute) return;
+        last.forecastMinute = minute;
+    }
+
+    out.push_back(static_cast<uint8_t>(event.type));
+    putVarint(out, event.timeMs > lastTimeMs_ ? static_cast<uint64_t>(event.timeMs - lastTimeMs_) : 0);
+    if (event.timeMs > lastTimeMs_) lastTimeMs_ = event.timeMs;
+    if (hasCallsign(event.type)) putVarint(out, id);
+
+    Last unused;
+    Last& last = hasCallsign(event.type) ? last_[id] : unused;
+    switch (event.type) {
+    case RecordType::RADAR_POSITION:
+        putDelta(out, event.latitude, last.latitude);
+        putDelta(out, event.longitude, last.longitude);
+        putDelta(out, event.altitude, last.altitude);
+        putDelta(out, event.groundSpeed, last.groundSpeed);
+        break;
+    case RecordType::FLIGHT_PLAN_DATA:
+        putDelta(out, event.entryMinutes, last.entryMinutes);
+        putDelta(out, event.exitMinutes, last.exitMinutes);
+        break;
+    case RecordType::CONTROLLER_ASSIGNED:
+        putVarint(out, static_cast<uint32_t>(event.code));
+        out.push_back(event.flags);
+        break;
+    case RecordType::CONTROLLER_POSITION:
+        out.push_back(event.flags);
+        putVarint(out, static_cast<uint32_t>(event.facility));
+        putVarint(out, static_cast<uint32_t>(event.rating));
+        putVarint(out, static_cast<uint32_t>(event.frequencyKhz));
+        putDelta(out, event.latitude, last.latitude);
+        putDelta(out, event.longitude, last.longitude);
+        putVarint(out, static_cast<uint32_t>(event.range));
+        break;
+    case RecordType::CONNECTION_TYPE:
+        putVarint(out, static_cast<uint32_t>(event.code));
+        break;
+    default:
+        break;
+    }
+}
+
+bool SessionRecorder::start(const std::string& path, int64_t nowMs)
+{
+    if (isRecording()) return false;
+
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) return false;
+    FileHeader header{ FILE_MAGIC, FILE_VERSION, nowMs };
+    if (std::fwrite(&header, sizeof(header), 1, file_) != 1) {
+        std::fclose(file_);
+        file_ = nullptr;
+        return false;
+    }
+
+    head_ = 0;
+    tail_ = 0;
+    recorded_ = 0;
+    dropped_ = 0;
+    bytesWritten_ = sizeof(header);
+    stop_ = false;
+    recording_ = true;
+    writer_ = std::thread(&SessionRecorder::run, this, nowMs);
+    return true;
+}
+
+void SessionRecorder::stop()
+{
+    if (!writer_.joinable()) return;
+    recording_ = false;
+    stop_ = true;
+    writer_.join();
+    std::fclose(file_);
+    file_ = nullptr;
+}
+
+bool SessionRecorder::enqueue(const Event& event)
+{
+    if (!recording_.load(std::memory_order_relaxed)) return false;
+
+    uint64_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) >= QUEUE_CAPACITY) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    queue_[head & (QUEUE_CAPACITY - 1)] = event;
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+void SessionRecorder::run(int64_t startMs)
+{
+    SessionEncoder encoder(startMs);
+    std::vector<uint8_t> buffer;
+    buffer.reserve(64 * 1024);
+    auto lastFlush = std::chrono::steady_clock::now();
+
+    while (true) {
+        bool stopping = stop_.load(std::memory_order_relaxed);
+        if (!stopping) std::this_thread::sleep_for(std::chrono::milliseconds(WRITE_INTERVAL_MS));
+
+        uint64_t tail = tail_.load(std::memory_order_relaxed);
+        uint64_t head = head_.load(std::memory_order_acquire);
+        for (; tail != head; ++tail) encoder.encode(queue_[tail & (QUEUE_CAPACITY - 1)], buffer);
+        tail_.store(tail, std::memory_order_release);
+        recorded_.store(tail, std::memory_order_relaxed);
+
+        if (!buffer.empty() && std::fwrite(buffer.data(), 1, buffer.size(), file_) == buffer.size())
+            bytesWritten_.fetch_add(buffer.size(), std::memory_order_relaxed);
+        buffer.clear();
+
+        // Flushed regularly so a crash loses at most a couple of seconds of capture
+        auto now = std::chrono::steady_clock::now();
+        if (stopping || now - lastFlush >= std::chrono::milliseconds(FLUSH_INTERVAL_MS)) {
+            std::fflush(file_);
+            lastFlush = now;
+        }
+        if (stopping) return;
+    }
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "SessionFormat.h"
+
+namespace rpc {
+    // Turns captured events into the session byte stream, interning callsigns on first use.
+    // FLIGHT_PLAN_DATA repeating the previous sector minutes within the same minute is skipped:
+    // the plugin feeds it on every position update but it only matters when it changes.
+    class SessionEncoder
+    {
+    public:
+        explicit SessionEncoder(int64_t startMs) : lastTimeMs_(startMs) {}
+
+        void encode(const session::Event& event, std::vector<uint8_t>& out);
+
+    private:
+        struct Last {
+            int32_t latitude = 0;
+            int32_t longitude = 0;
+            int32_t altitude = 0;
+            int32_t groundSpeed = 0;
+            int32_t entryMinutes = -1;
+            int32_t exitMinutes = -1;
+            int64_t forecastMinute = -1; // minute of the last FLIGHT_PLAN_DATA written
+        };
+
+        uint32_t intern(const char* callsign, std::vector<uint8_t>& out);
+
+    private:
+        int64_t lastTimeMs_;
+        std::unordered_map<std::string, uint32_t> ids_;
+        std::vector<Last> last_; // by callsign id
+    };
+
+    // Captures SDK callbacks to a session file. EuroScope's thread only copies the event into a
+    // single producer ring; a writer thread encodes the ring every WRITE_INTERVAL_MS and writes it
+    // in batches, so disk latency never reaches the SDK callbacks.
+    class SessionRecorder
+    {
+    public:
+        static constexpr size_t QUEUE_CAPACITY = 8192; // events, power of two
+        static constexpr int64_t WRITE_INTERVAL_MS = 250;
+        static constexpr int64_t FLUSH_INTERVAL_MS = 2000;
+
+        ~SessionRecorder() { stop(); }
+
+        bool start(const std::string& path, int64_t nowMs);
+        void stop();
+        bool isRecording() const { return recording_.load(std::memory_order_relaxed); }
+
+        // Producer thread only. False when not recording or the ring is full (counted as dropped).
+        bool enqueue(const session::Event& event);
+
+        uint64_t getRecorded() const { return recorded_.load(std::memory_order_relaxed); }
+        uint64_t getDropped() const { return dropped_.load(std::memory_order_relaxed); }
+        uint64_t getBytesWritten() const { return bytesWritten_.load(std::memory_order_relaxed); }
+
+    private:
+        void run(int64_t startMs);
+
+    private:
+        std::atomic<bool> recording_{ false };
+        std::atomic<bool> stop_{ false };
+        std::thread writer_;
+        FILE* file_ = nullptr;
+
+        std::array<session::Event, QUEUE_CAPACITY> queue_;
+        alignas(64) std::atomic<uint64_t> head_{ 0 }; // written by the producer
+        alignas(64) std::atomic<uint64_t> tail_{ 0 }; // written by the writer thread
+
+        std::atomic<uint64_t> recorded_{ 0 };
+        std::atomic<uint64_t> dropped_{ 0 };
+        std::atomic<uint64_t> bytesWritten_{ 0 };
+    };
+} // namespace rpc
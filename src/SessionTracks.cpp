@@ -0,0 +1,42 @@
+#include "SessionTracks.h"
+
+using namespace rpc;
+
+SessionTracks::Join SessionTracks::start(PackedCallsign callsign)
+{
+    auto [entry, inserted] = entries_.tryEmplace(callsign);
+    if (!entry) return Join::NONE;
+    entry->status = Status::TRACKED;
+    if (entry->listed) return Join::NONE;
+    entry->listed = true;
+    return inserted ? Join::FIRST : Join::RELISTED;
+}
+
+void SessionTracks::release(PackedCallsign callsign)
+{
+    if (Entry* entry = entries_.find(callsign)) entry->status = Status::RELEASED;
+}
+
+void SessionTracks::releaseAll()
+{
+    entries_.forEach([](PackedCallsign, Entry& entry) { entry.status = Status::RELEASED; });
+}
+
+bool SessionTracks::disconnect(PackedCallsign callsign)
+{
+    Entry* entry = entries_.find(callsign);
+    if (!entry || !entry->listed) return false;
+    entry->listed = false;
+    entry->status = Status::RELEASED;
+    return true;
+}
+
+void SessionTracks::reset()
+{
+    entries_.clear();
+}
+
+const char* SessionTracks::statusText(Status status)
+{
+    return status == Status::TRACKED ? "Mine" : "Released";
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include "Callsign.h"
+
+namespace rpc {
+    // Every aircraft I tracked this session and whether it is still mine. Maintained from
+    // tracking events as deltas: the caller adds the flight plan to its list when start() says it
+    // joins and removes it when disconnect() says it was listed, nothing is rebuilt per refresh.
+    // EuroScope thread only.
+    class SessionTracks
+    {
+    public:
+        enum class Status : uint8_t {
+            TRACKED = 0,
+            RELEASED
+        };
+
+        enum class Join : uint8_t {
+            NONE = 0, // already listed
+            FIRST,    // first track of this aircraft this session
+            RELISTED  // tracked again after its flight plan disconnected
+        };
+
+        struct Entry {
+            Status status = Status::TRACKED;
+            bool listed = false;
+        };
+
+        Join start(PackedCallsign callsign);
+        void release(PackedCallsign callsign);
+        // Disconnected from the network, nothing is mine any more; the list keeps its aircraft
+        void releaseAll();
+        // True when the aircraft was listed and has to leave the list
+        bool disconnect(PackedCallsign callsign);
+        void reset();
+
+        const Entry* find(PackedCallsign callsign) const { return entries_.find(callsign); }
+        size_t size() const { return entries_.size(); } // aircraft tracked this session
+
+        static const char* statusText(Status status);
+
+    private:
+        CallsignMap<Entry> entries_{ 256 };
+    };
+} // namespace rpc
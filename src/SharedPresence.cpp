@@ -0,0 +1,213 @@
+#include "SharedPresence.h"
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+using namespace rpc;
+
+namespace {
+    constexpr uint32_t SEGMENT_MAGIC = 0x45535250; // "ESRP"
+    constexpr uint32_t SEGMENT_VERSION = 1;
+    constexpr int SNAPSHOT_ATTEMPTS = 8; // a store in progress takes well under a microsecond
+#ifdef _WIN32
+    constexpr const wchar_t* SEGMENT_NAME = L"Local\\EuroscopeRPC.Presence";
+#else
+    constexpr const char* SEGMENT_NAME = "/EuroscopeRPC.Presence";
+#endif
+}
+
+static_assert(std::atomic<int64_t>::is_always_lock_free, "shared memory atomics must be lock free");
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "shared memory atomics must be lock free");
+
+SharedPresence::SharedPresence() : pid_(processId())
+{
+}
+
+SharedPresence::~SharedPresence()
+{
+    close();
+}
+
+bool SharedPresence::open()
+{
+    if (segment_) return true;
+
+#ifdef _WIN32
+    HANDLE mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, sizeof(Segment), SEGMENT_NAME);
+    if (!mapping) return false;
+    void* view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(Segment));
+    if (!view) {
+        CloseHandle(mapping);
+        return false;
+    }
+    handle_ = mapping;
+#else
+    int fd = shm_open(SEGMENT_NAME, O_CREAT | O_RDWR, 0600);
+    if (fd < 0) return false;
+    if (ftruncate(fd, sizeof(Segment)) != 0) {
+        ::close(fd);
+        return false;
+    }
+    void* view = mmap(nullptr, sizeof(Segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED) return false;
+#endif
+
+    // Fresh mappings are zero filled, which is a valid state for every lock free atomic of the layout
+    segment_ = static_cast<Segment*>(view);
+    uint32_t expected = 0;
+    if (segment_->magic.compare_exchange_strong(expected, SEGMENT_MAGIC)) segment_->version = SEGMENT_VERSION;
+    else if (expected != SEGMENT_MAGIC || segment_->version != SEGMENT_VERSION) {
+        close();
+        return false;
+    }
+
+    if (!claimSlot()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void SharedPresence::close()
+{
+    if (!segment_) return;
+
+    if (slot_ >= 0) {
+        uint32_t expected = pid_;
+        segment_->slots[slot_].owner.compare_exchange_strong(expected, 0);
+        slot_ = -1;
+    }
+
+#ifdef _WIN32
+    UnmapViewOfFile(segment_);
+    CloseHandle(static_cast<HANDLE>(handle_));
+#else
+    munmap(segment_, sizeof(Segment));
+#endif
+    segment_ = nullptr;
+    handle_ = nullptr;
+    leader_ = true;
+}
+
+bool SharedPresence::tick(const InstanceSnapshot& snapshot)
+{
+    if (!segment_) {
+        leader_.store(true, std::memory_order_relaxed);
+        return true;
+    }
+
+    int64_t now = nowMs();
+    Slot& own = segment_->slots[slot_];
+    if (own.owner.load(std::memory_order_acquire) != pid_ && !claimSlot()) {
+        // Our slot was reclaimed after a long stall and no other is free
+        leader_.store(true, std::memory_order_relaxed);
+        return true;
+    }
+    segment_->slots[slot_].snapshot.store(snapshot);
+    segment_->slots[slot_].heartbeat.store(now, std::memory_order_release);
+
+    int leader = slot_;
+    for (int i = 0; i < static_cast<int>(MAX_INSTANCES); ++i) {
+        if (i == slot_ || isLive(segment_->slots[i], now)) {
+            leader = i;
+            break;
+        }
+    }
+    leader_.store(leader == slot_, std::memory_order_relaxed);
+    return leader == slot_;
+}
+
+uint32_t SharedPresence::heartbeat()
+{
+    if (!segment_) return 1;
+
+    int64_t now = nowMs();
+    int own = slot_.load(std::memory_order_relaxed);
+    if (own >= 0 && segment_->slots[own].owner.load(std::memory_order_acquire) == pid_)
+        segment_->slots[own].heartbeat.store(now, std::memory_order_release);
+
+    uint32_t live = 0;
+    for (int i = 0; i < static_cast<int>(MAX_INSTANCES); ++i) {
+        if (i == own || isLive(segment_->slots[i], now)) ++live;
+    }
+    return live;
+}
+
+SharedPresence::Merged SharedPresence::merge() const
+{
+    Merged merged;
+    if (!segment_) return merged;
+
+    int64_t now = nowMs();
+    for (int i = 0; i < static_cast<int>(MAX_INSTANCES); ++i) {
+        const Slot& slot = segment_->slots[i];
+        if (i != slot_ && !isLive(slot, now)) continue;
+
+        // Another process may have died inside its store and left the sequence odd: never spin on it,
+        // the slot just does not count for this tick and goes stale with its heartbeat
+        InstanceSnapshot snapshot;
+        if (!slot.snapshot.tryLoad(snapshot, SNAPSHOT_ATTEMPTS)) continue;
+        ++merged.instances;
+        merged.total = std::max(merged.total, snapshot.total);
+        if (!snapshot.controlling) continue;
+
+        ++merged.controlling;
+        merged.tracked += snapshot.tracked;
+        std::string callsign(snapshot.callsign, strnlen(snapshot.callsign, sizeof(snapshot.callsign)));
+        if (callsign.empty()) continue;
+        if (!merged.callsigns.empty()) merged.callsigns += " + ";
+        merged.callsigns += callsign;
+    }
+    return merged;
+}
+
+int64_t SharedPresence::nowMs()
+{
+    // steady_clock is system wide on both platforms (QPC / CLOCK_MONOTONIC), heartbeats compare across processes
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint32_t SharedPresence::processId()
+{
+#ifdef _WIN32
+    return static_cast<uint32_t>(GetCurrentProcessId());
+#else
+    return static_cast<uint32_t>(getpid());
+#endif
+}
+
+bool SharedPresence::isLive(const Slot& slot, int64_t now) const
+{
+    return slot.owner.load(std::memory_order_acquire) != 0 &&
+        now - slot.heartbeat.load(std::memory_order_acquire) <= STALE_MS;
+}
+
+bool SharedPresence::claimSlot()
+{
+    int64_t now = nowMs();
+    for (int pass = 0; pass < 2; ++pass) {
+        for (int i = 0; i < static_cast<int>(MAX_INSTANCES); ++i) {
+            Slot& slot = segment_->slots[i];
+            uint32_t owner = slot.owner.load(std::memory_order_acquire);
+            // First pass only takes free slots, the second one also reclaims crashed instances
+            bool claimable = owner == 0 || owner == pid_ || (pass == 1 && !isLive(slot, now));
+            if (!claimable) continue;
+            if (owner == pid_ || slot.owner.compare_exchange_strong(owner, pid_, std::memory_order_acq_rel)) {
+                slot.heartbeat.store(now, std::memory_order_release);
+                slot_ = i;
+                return true;
+            }
+        }
+    }
+    return false;
+}
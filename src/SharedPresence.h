@@ -0,0 +1,83 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include "Seqlock.h"
+
+namespace rpc {
+    // What one EuroScope instance publishes to the others
+    struct InstanceSnapshot {
+        int32_t state = 0; // State enum
+        bool controlling = false;
+        uint32_t tracked = 0;
+        uint32_t total = 0;
+        char callsign[16] = {};
+        char frequency[12] = {};
+    };
+
+    // Presence shared by every EuroScope instance of the machine through a small named shared memory
+    // segment. Each instance owns a slot holding a heartbeat and a seqlock protected snapshot; readers
+    // never block writers. The live instance with the lowest slot is the leader, it alone keeps the
+    // Discord connection and renders the merged presence. A clean shutdown frees the slot so the next
+    // instance takes over on its next tick, a crashed one is skipped once its heartbeat goes stale.
+    class SharedPresence
+    {
+    public:
+        static constexpr size_t MAX_INSTANCES = 8;
+        // Heartbeats come from OnTimer on EuroScope's UI thread, which a sector file load or a modal
+        // dialog can hold for seconds; four missed ticks are needed before a leader counts as dead, so
+        // a busy one is not replaced and two Discord connections do not flap. Failover stays within
+        // one tick for a clean exit, which frees the slot; a crashed leader is replaced by the first
+        // tick after its heartbeat is 4 s old, at most 5 s after its last one.
+        static constexpr int64_t STALE_MS = 4000;
+
+        struct Merged {
+            uint32_t instances = 0;
+            uint32_t controlling = 0;
+            uint32_t tracked = 0;
+            uint32_t total = 0;
+            std::string callsigns; // "LFPG_TWR + LFPG_GND"
+        };
+
+        SharedPresence();
+        ~SharedPresence();
+
+        // Maps the segment and claims a slot, false when running standalone (mapping failed or full)
+        bool open();
+        void close();
+
+        // Publishes the snapshot, refreshes the heartbeat and re-runs the election. Returns isLeader().
+        bool tick(const InstanceSnapshot& snapshot);
+        // Refreshes the heartbeat alone, from a thread that runs every second whatever the presence
+        // thread does, so a parked presence thread still holds its slot. Returns the live instances.
+        uint32_t heartbeat();
+        // Standalone instances are always leader
+        bool isLeader() const { return leader_.load(std::memory_order_relaxed); }
+        Merged merge() const;
+
+    private:
+        struct Slot {
+            std::atomic<uint32_t> owner; // process id, 0 when free
+            std::atomic<int64_t> heartbeat;
+            Seqlock<InstanceSnapshot> snapshot;
+        };
+
+        struct Segment {
+            std::atomic<uint32_t> magic;
+            uint32_t version;
+            Slot slots[MAX_INSTANCES];
+        };
+
+        static int64_t nowMs();
+        static uint32_t processId();
+        bool isLive(const Slot& slot, int64_t now) const;
+        bool claimSlot();
+
+    private:
+        Segment* segment_ = nullptr;
+        void* handle_ = nullptr; // platform mapping handle
+        std::atomic<int> slot_{ -1 }; // moves only when a stalled instance reclaims a slot
+        uint32_t pid_ = 0;
+        std::atomic<bool> leader_{ true };
+    };
+} // namespace rpc
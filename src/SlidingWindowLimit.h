@@ -0,0 +1,34 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+namespace rpc {
+    // At most LIMIT events in any window: keeps the times of the last LIMIT events taken and lets a
+    // new one through only when the oldest of them has left the window. Unlike a token bucket it
+    // never allows more than LIMIT in a window straddling a refill. Single threaded, the caller
+    // passes the time.
+    template <size_t LIMIT>
+    class SlidingWindowLimit
+    {
+        static_assert(LIMIT > 0, "SlidingWindowLimit needs room for one event");
+
+    public:
+        explicit SlidingWindowLimit(uint64_t windowNs) : windowNs_(windowNs) {}
+
+        bool tryTake(uint64_t nowNs)
+        {
+            uint64_t& oldest = times_[next_];
+            if (taken_ == LIMIT && nowNs - oldest < windowNs_) return false;
+            oldest = nowNs;
+            next_ = (next_ + 1) % LIMIT;
+            if (taken_ < LIMIT) ++taken_;
+            return true;
+        }
+
+    private:
+        uint64_t windowNs_;
+        std::array<uint64_t, LIMIT> times_{}; // ring, next_ is the oldest once full
+        size_t next_ = 0;
+        size_t taken_ = 0;
+    };
+} // namespace rpc
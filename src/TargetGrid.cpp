@@ -0,0 +1,236 @@
+#include "TargetGrid.h"
+#include <algorithm>
+#include <cmath>
+#include "Geo.h"
+
+using namespace rpc;
+
+namespace {
+    constexpr int LAT_CELLS = static_cast<int>(180.0 / TargetGrid::CELL_DEGREES);
+    constexpr int LON_CELLS = static_cast<int>(360.0 / TargetGrid::CELL_DEGREES);
+}
+
+void TargetGrid::update(PackedCallsign callsign, double latitude, double longitude, int64_t now)
+{
+    if (callsign == INVALID_CALLSIGN) return;
+
+    uint32_t cell = cellKey(latitudeIndex(latitude), longitudeIndex(longitude));
+    auto [index, inserted] = indices_.tryEmplace(callsign);
+    if (inserted) {
+        *index = static_cast<uint32_t>(targets_.size());
+        Target target;
+        target.callsign = callsign;
+        target.cell = cell;
+        targets_.push_back(target);
+        insertIntoCell(*index);
+    }
+    else if (targets_[*index].cell != cell) {
+        removeFromCell(*index);
+        targets_[*index].cell = cell;
+        insertIntoCell(*index);
+    }
+
+    Target& target = targets_[*index];
+    target.latitude = latitude;
+    target.longitude = longitude;
+    target.lastUpdate = now;
+    setInRange(target, referenceRangeNm_ > 0.0 &&
+        geo::distanceNm(referenceLatitude_, referenceLongitude_, latitude, longitude) <= referenceRangeNm_);
+}
+
+void TargetGrid::remove(PackedCallsign callsign)
+{
+    uint32_t* index = indices_.find(callsign);
+    if (index) removeAt(*index);
+}
+
+void TargetGrid::expire(int64_t now, int64_t maxAge)
+{
+    for (size_t i = targets_.size(); i-- > 0;) {
+        if (now - targets_[i].lastUpdate > maxAge) removeAt(static_cast<uint32_t>(i));
+    }
+}
+
+void TargetGrid::reset()
+{
+    targets_.clear();
+    indices_.clear();
+    cells_.clear();
+    inRangeCount_ = 0;
+}
+
+void TargetGrid::setReference(double latitude, double longitude, double rangeNm)
+{
+    if (latitude == referenceLatitude_ && longitude == referenceLongitude_ && rangeNm == referenceRangeNm_) return;
+
+    referenceLatitude_ = latitude;
+    referenceLongitude_ = longitude;
+    referenceRangeNm_ = rangeNm;
+    hasReference_.store(rangeNm > 0.0, std::memory_order_relaxed);
+
+    for (Target& target : targets_) target.inRange = false;
+    uint32_t count = 0;
+    if (rangeNm > 0.0) {
+        visitCircle(latitude, longitude, rangeNm, [&](const std::vector<uint32_t>& members, bool fullyInside) {
+            for (uint32_t index : members) {
+                Target& target = targets_[index];
+                target.inRange = fullyInside ||
+                    geo::distanceNm(latitude, longitude, target.latitude, target.longitude) <= rangeNm;
+                if (target.inRange) ++count;
+            }
+        });
+    }
+    inRangeCount_.store(count, std::memory_order_relaxed);
+}
+
+uint32_t TargetGrid::countWithin(double latitude, double longitude, double rangeNm) const
+{
+    uint32_t count = 0;
+    visitCircle(latitude, longitude, rangeNm, [&](const std::vector<uint32_t>& members, bool fullyInside) {
+        if (fullyInside) {
+            count += static_cast<uint32_t>(members.size());
+            return;
+        }
+        for (uint32_t index : members) {
+            const Target& target = targets_[index];
+            if (geo::distanceNm(latitude, longitude, target.latitude, target.longitude) <= rangeNm) ++count;
+        }
+    });
+    return count;
+}
+
+uint32_t TargetGrid::countInBox(double minLatitude, double minLongitude, double maxLatitude, double maxLongitude) const
+{
+    if (minLatitude > maxLatitude) return 0;
+    bool wraps = minLongitude > maxLongitude; // box crossing the antimeridian
+
+    int minLat = latitudeIndex(minLatitude);
+    int maxLat = latitudeIndex(maxLatitude);
+    int minLon = longitudeIndex(minLongitude);
+    int lonCells = (longitudeIndex(maxLongitude) - minLon + LON_CELLS) % LON_CELLS + 1;
+
+    auto insideLongitude = [&](double longitude) {
+        return wraps ? (longitude >= minLongitude || longitude <= maxLongitude)
+                     : (longitude >= minLongitude && longitude <= maxLongitude);
+    };
+
+    uint32_t count = 0;
+    for (int latIndex = minLat; latIndex <= maxLat; ++latIndex) {
+        double cellMinLat = latIndex * CELL_DEGREES - 90.0;
+        bool latInside = cellMinLat >= minLatitude && cellMinLat + CELL_DEGREES <= maxLatitude;
+        for (int step = 0; step < lonCells; ++step) {
+            int lonIndex = (minLon + step) % LON_CELLS;
+            auto cell = cells_.find(cellKey(latIndex, lonIndex));
+            if (cell == cells_.end()) continue;
+
+            // Edge cells are the first and last columns, every member in between is inside
+            if (latInside && step > 0 && step < lonCells - 1) {
+                count += static_cast<uint32_t>(cell->second.size());
+                continue;
+            }
+            for (uint32_t index : cell->second) {
+                const Target& target = targets_[index];
+                if (target.latitude >= minLatitude && target.latitude <= maxLatitude && insideLongitude(target.longitude))
+                    ++count;
+            }
+        }
+    }
+    return count;
+}
+
+int TargetGrid::latitudeIndex(double latitude)
+{
+    return std::clamp(static_cast<int>(std::floor((latitude + 90.0) / CELL_DEGREES)), 0, LAT_CELLS - 1);
+}
+
+int TargetGrid::longitudeIndex(double longitude)
+{
+    int index = static_cast<int>(std::floor((longitude + 180.0) / CELL_DEGREES)) % LON_CELLS;
+    return index < 0 ? index + LON_CELLS : index;
+}
+
+uint32_t TargetGrid::cellKey(int latIndex, int lonIndex)
+{
+    return static_cast<uint32_t>(latIndex * LON_CELLS + lonIndex);
+}
+
+void TargetGrid::insertIntoCell(uint32_t index)
+{
+    std::vector<uint32_t>& members = cells_[targets_[index].cell];
+    targets_[index].slot = static_cast<uint32_t>(members.size());
+    members.push_back(index);
+}
+
+void TargetGrid::removeFromCell(uint32_t index)
+{
+    auto cell = cells_.find(targets_[index].cell);
+    if (cell == cells_.end()) return;
+
+    std::vector<uint32_t>& members = cell->second;
+    uint32_t last = members.back();
+    members[targets_[index].slot] = last;
+    targets_[last].slot = targets_[index].slot;
+    members.pop_back();
+    if (members.empty()) cells_.erase(cell);
+}
+
+void TargetGrid::removeAt(uint32_t index)
+{
+    removeFromCell(index);
+    setInRange(targets_[index], false);
+    indices_.erase(targets_[index].callsign);
+
+    uint32_t last = static_cast<uint32_t>(targets_.size() - 1);
+    if (index != last) {
+        targets_[index] = targets_[last];
+        cells_[targets_[index].cell][targets_[index].slot] = index;
+        *indices_.find(targets_[index].callsign) = index;
+    }
+    targets_.pop_back();
+}
+
+void TargetGrid::setInRange(Target& target, bool inRange)
+{
+    if (target.inRange == inRange) return;
+    target.inRange = inRange;
+    if (inRange) inRangeCount_.fetch_add(1, std::memory_order_relaxed);
+    else inRangeCount_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+template <typename Fn>
+void TargetGrid::visitCircle(double latitude, double longitude, double rangeNm, Fn&& fn) const
+{
+    double latSpan = rangeNm / 60.0;
+    int minLat = latitudeIndex(latitude - latSpan);
+    int maxLat = latitudeIndex(latitude + latSpan);
+
+    // Longitude span widens with latitude, near the poles every column is touched
+    int minLon = 0;
+    int lonCells = LON_CELLS;
+    double extremeLatitude = std::fabs(latitude) + latSpan;
+    if (extremeLatitude < 89.0) {
+        double lonSpan = latSpan / std::cos(extremeLatitude * geo::DEG_TO_RAD);
+        if (lonSpan < 180.0) {
+            minLon = longitudeIndex(longitude - lonSpan);
+            lonCells = std::min(LON_CELLS, (longitudeIndex(longitude + lonSpan) - minLon + LON_CELLS) % LON_CELLS + 1);
+        }
+    }
+
+    for (int latIndex = minLat; latIndex <= maxLat; ++latIndex) {
+        double cellMinLat = latIndex * CELL_DEGREES - 90.0;
+        for (int step = 0; step < lonCells; ++step) {
+            int lonIndex = (minLon + step) % LON_CELLS;
+            auto cell = cells_.find(cellKey(latIndex, lonIndex));
+            if (cell == cells_.end()) continue;
+
+            // The farthest point of a small lat/lon cell is one of its corners
+            double cellMinLon = lonIndex * CELL_DEGREES - 180.0;
+            double farthest = std::max({
+                geo::distanceNm(latitude, longitude, cellMinLat, cellMinLon),
+                geo::distanceNm(latitude, longitude, cellMinLat + CELL_DEGREES, cellMinLon),
+                geo::distanceNm(latitude, longitude, cellMinLat, cellMinLon + CELL_DEGREES),
+                geo::distanceNm(latitude, longitude, cellMinLat + CELL_DEGREES, cellMinLon + CELL_DEGREES) });
+            fn(cell->second, farthest <= rangeNm);
+        }
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "Callsign.h"
+
+namespace rpc {
+    // Uniform lat/lon grid of radar targets fed by position updates.
+    // Range and box queries only visit the cells they overlap; cells entirely inside a range are
+    // counted without any distance computation. The number of targets inside my own range is
+    // maintained on every update so reading it is a single atomic load.
+    class TargetGrid
+    {
+    public:
+        static constexpr double CELL_DEGREES = 0.5;
+
+        void update(PackedCallsign callsign, double latitude, double longitude, int64_t now);
+        void remove(PackedCallsign callsign);
+        // Drops targets without position update since maxAge, O(targets)
+        void expire(int64_t now, int64_t maxAge);
+        void reset();
+
+        // Center and radius of "my range", the in range count is rebuilt through the grid when it changes
+        void setReference(double latitude, double longitude, double rangeNm);
+        bool hasReference() const { return hasReference_.load(std::memory_order_relaxed); }
+
+        uint32_t countWithin(double latitude, double longitude, double rangeNm) const;
+        uint32_t countInBox(double minLatitude, double minLongitude, double maxLatitude, double maxLongitude) const;
+        size_t size() const { return targets_.size(); }
+
+        // Safe to call from any thread
+        uint32_t getInRangeCount() const { return inRangeCount_.load(std::memory_order_relaxed); }
+
+    private:
+        struct Target {
+            PackedCallsign callsign = INVALID_CALLSIGN;
+            double latitude = 0.0;
+            double longitude = 0.0;
+            int64_t lastUpdate = 0;
+            uint32_t cell = 0;
+            uint32_t slot = 0; // index inside the cell list
+            bool inRange = false;
+        };
+
+        static int latitudeIndex(double latitude);
+        static int longitudeIndex(double longitude);
+        static uint32_t cellKey(int latIndex, int lonIndex);
+
+        void insertIntoCell(uint32_t index);
+        void removeFromCell(uint32_t index);
+        void removeAt(uint32_t index);
+        void setInRange(Target& target, bool inRange);
+
+        // Calls fn(cell members, fully inside) for every cell overlapping the circle
+        template <typename Fn>
+        void visitCircle(double latitude, double longitude, double rangeNm, Fn&& fn) const;
+
+    private:
+        std::vector<Target> targets_;
+        CallsignMap<uint32_t> indices_{ 512 };
+        std::unordered_map<uint32_t, std::vector<uint32_t>> cells_;
+
+        double referenceLatitude_ = 0.0;
+        double referenceLongitude_ = 0.0;
+        double referenceRangeNm_ = 0.0;
+        std::atomic<bool> hasReference_{ false };
+        std::atomic<uint32_t> inRangeCount_{ 0 };
+    };
+} // namespace rpc
@@ -0,0 +1,42 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+
+namespace rpc {
+    // Token bucket on a nanosecond clock: burst takes at once, then one more every interval.
+    // Single threaded, the caller passes the time.
+    class TokenBucket
+    {
+    public:
+        TokenBucket(uint32_t burst, uint64_t intervalNs) : burst_(burst), intervalNs_(intervalNs), tokens_(burst) {}
+
+        bool tryTake(uint64_t nowNs)
+        {
+            refill(nowNs);
+            if (tokens_ == 0) return false;
+            --tokens_;
+            return true;
+        }
+
+        uint32_t getTokens() const { return tokens_; }
+
+    private:
+        void refill(uint64_t nowNs)
+        {
+            if (lastRefill_ == 0 || nowNs < lastRefill_) {
+                lastRefill_ = nowNs;
+                return;
+            }
+            uint64_t earned = (nowNs - lastRefill_) / intervalNs_;
+            if (earned == 0) return;
+            lastRefill_ += earned * intervalNs_;
+            tokens_ = static_cast<uint32_t>(std::min<uint64_t>(burst_, tokens_ + earned));
+        }
+
+    private:
+        uint32_t burst_;
+        uint64_t intervalNs_;
+        uint32_t tokens_;
+        uint64_t lastRefill_ = 0;
+    };
+} // namespace rpc
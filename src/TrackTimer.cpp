@@ -0,0 +1,28 @@
+#include "TrackTimer.h"
+#include <algorithm>
+#include <cstdio>
+
+using namespace rpc;
+
+void TrackTimer::start(PackedCallsign callsign, int64_t nowSeconds)
+{
+    auto [entry, inserted] = entries_.tryEmplace(callsign);
+    if (inserted) entry->startSeconds = nowSeconds;
+}
+
+int64_t TrackTimer::stop(PackedCallsign callsign, int64_t nowSeconds)
+{
+    const Entry* entry = entries_.find(callsign);
+    if (!entry) return -1;
+    int64_t elapsed = std::max<int64_t>(0, nowSeconds - entry->startSeconds);
+    entries_.erase(callsign);
+    return elapsed;
+}
+
+void TrackTimer::render(Entry& entry, int32_t minutes)
+{
+    entry.shownMinutes = minutes;
+    minutes = std::clamp(minutes, 0, 99 * 60 + 59);
+    if (minutes < 60) std::snprintf(entry.text, sizeof(entry.text), "%dm", minutes);
+    else std::snprintf(entry.text, sizeof(entry.text), "%dh%02d", minutes / 60, minutes % 60);
+}
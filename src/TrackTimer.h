@@ -0,0 +1,52 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include "Callsign.h"
+
+namespace rpc {
+    // How long I have been tracking each aircraft, for the tag item and the time under control
+    // statistics. OnGetTagItem asks for every tag on every scope refresh, so a lookup is one probe
+    // into the packed callsign table and the text is rendered into the entry only when the minute
+    // it shows changes. EuroScope thread only.
+    class TrackTimer
+    {
+    public:
+        static constexpr size_t TEXT_SIZE = 8; // "59m", "23h59"
+
+        // Tracking began, an aircraft already tracked keeps its start
+        void start(PackedCallsign callsign, int64_t nowSeconds);
+        // Tracking ended, returns how long it lasted or -1 when the aircraft was not tracked
+        int64_t stop(PackedCallsign callsign, int64_t nowSeconds);
+        // Ends every interval, for a disconnect or shutdown
+        template <typename Sink>
+        void stopAll(int64_t nowSeconds, Sink&& sink)
+        {
+            entries_.forEach([&](PackedCallsign, const Entry& entry) { sink(std::max<int64_t>(0, nowSeconds - entry.startSeconds)); });
+            entries_.clear();
+        }
+
+        // Duration text for the tag, nullptr when the aircraft is not tracked by me
+        const char* text(PackedCallsign callsign, int64_t nowSeconds)
+        {
+            Entry* entry = entries_.find(callsign);
+            if (!entry) return nullptr;
+            int32_t minutes = static_cast<int32_t>((nowSeconds - entry->startSeconds) / 60);
+            if (minutes != entry->shownMinutes) render(*entry, minutes);
+            return entry->text;
+        }
+
+        size_t size() const { return entries_.size(); }
+
+    private:
+        struct Entry {
+            int64_t startSeconds = 0;
+            int32_t shownMinutes = -1;
+            char text[TEXT_SIZE] = {};
+        };
+
+        static void render(Entry& entry, int32_t minutes);
+
+    private:
+        CallsignMap<Entry> entries_{ 64 };
+    };
+} // namespace rpc
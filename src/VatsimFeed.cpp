@@ -0,0 +1,312 @@
+#include "VatsimFeed.h"
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RPC_JSON_SSE2 1
+#include <emmintrin.h>
+#endif
+
+using namespace rpc;
+
+namespace {
+    class MalformedJson {};
+
+    // Forward only scanner over the feed. Values we do not need are skipped by bracket matching,
+    // 16 bytes at a time where SSE2 is available.
+    class JsonScanner
+    {
+    public:
+        JsonScanner(const char* begin, const char* end) : p_(begin), end_(end) {}
+
+        bool atEnd() { skipWhitespace(); return p_ >= end_; }
+        const char* position() const { return p_; }
+
+        void expect(char c)
+        {
+            skipWhitespace();
+            if (p_ >= end_ || *p_ != c) throw MalformedJson();
+            ++p_;
+        }
+
+        bool consume(char c)
+        {
+            skipWhitespace();
+            if (p_ < end_ && *p_ == c) {
+                ++p_;
+                return true;
+            }
+            return false;
+        }
+
+        // Object members and array elements: true while there is one more
+        bool nextMember(bool& first, char close)
+        {
+            if (consume(close)) return false;
+            if (!first) expect(',');
+            first = false;
+            return true;
+        }
+
+        // Raw string content, escapes are left as is (callsigns and frequencies have none)
+        std::string_view readString()
+        {
+            expect('"');
+            const char* begin = p_;
+            skipStringBody();
+            return std::string_view(begin, static_cast<size_t>(p_ - 1 - begin));
+        }
+
+        double readNumber()
+        {
+            skipWhitespace();
+            double value = 0.0;
+            auto [next, error] = std::from_chars(p_, end_, value);
+            if (error != std::errc()) throw MalformedJson();
+            p_ = next;
+            return value;
+        }
+
+        bool readNull()
+        {
+            skipWhitespace();
+            if (end_ - p_ >= 4 && std::memcmp(p_, "null", 4) == 0) {
+                p_ += 4;
+                return true;
+            }
+            return false;
+        }
+
+        void skipValue()
+        {
+            skipWhitespace();
+            if (p_ >= end_) throw MalformedJson();
+            switch (*p_) {
+            case '"':
+                ++p_;
+                skipStringBody();
+                break;
+            case '{':
+            case '[':
+                skipContainer();
+                break;
+            default:
+                // number, true, false, null
+                while (p_ < end_ && *p_ != ',' && *p_ != '}' && *p_ != ']' && !isWhitespace(*p_)) ++p_;
+                break;
+            }
+        }
+
+    private:
+        static bool isWhitespace(char c) { return c == ' ' || c == '\n' || c == '\r' || c == '\t'; }
+
+        void skipWhitespace()
+        {
+            while (p_ < end_ && isWhitespace(*p_)) ++p_;
+        }
+
+        // p_ is just past the opening quote, leaves it just past the closing one
+        void skipStringBody()
+        {
+#ifdef RPC_JSON_SSE2
+            const __m128i quote = _mm_set1_epi8('"');
+            const __m128i backslash = _mm_set1_epi8('\\');
+            while (end_ - p_ >= 16) {
+                __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p_));
+                unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(block, quote), _mm_cmpeq_epi8(block, backslash))));
+                if (mask == 0) {
+                    p_ += 16;
+                    continue;
+                }
+                p_ += std::countr_zero(mask);
+                if (*p_ == '"') {
+                    ++p_;
+                    return;
+                }
+                p_ += 2; // escaped character
+            }
+#endif
+            while (p_ < end_) {
+                char c = *p_++;
+                if (c == '"') return;
+                if (c == '\\') ++p_;
+            }
+            throw MalformedJson();
+        }
+
+        // p_ is on the opening bracket, leaves it just past the matching closing one
+        void skipContainer()
+        {
+            int depth = 0;
+#ifdef RPC_JSON_SSE2
+            const __m128i quote = _mm_set1_epi8('"');
+            const __m128i openBrace = _mm_set1_epi8('{');
+            const __m128i closeBrace = _mm_set1_epi8('}');
+            const __m128i openBracket = _mm_set1_epi8('[');
+            const __m128i closeBracket = _mm_set1_epi8(']');
+            while (end_ - p_ >= 16) {
+                __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p_));
+                __m128i structural = _mm_or_si128(
+                    _mm_or_si128(_mm_cmpeq_epi8(block, quote), _mm_cmpeq_epi8(block, openBrace)),
+                    _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, closeBrace), _mm_cmpeq_epi8(block, openBracket)), _mm_cmpeq_epi8(block, closeBracket)));
+                unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(structural));
+                if (mask == 0) {
+                    p_ += 16;
+                    continue;
+                }
+                p_ += std::countr_zero(mask);
+                if (step(depth)) return;
+            }
+#endif
+            while (p_ < end_) {
+                if (step(depth)) return;
+            }
+            throw MalformedJson();
+        }
+
+        // Consumes one character of a container, true once the outermost one is closed
+        bool step(int& depth)
+        {
+            char c = *p_++;
+            if (c == '"') skipStringBody();
+            else if (c == '{' || c == '[') ++depth;
+            else if (c == '}' || c == ']') return --depth == 0;
+            return false;
+        }
+
+    private:
+        const char* p_;
+        const char* end_;
+    };
+
+    void copyCallsign(char (&destination)[16], std::string_view source)
+    {
+        size_t length = std::min(source.size(), sizeof(destination) - 1);
+        std::memcpy(destination, source.data(), length);
+        destination[length] = '\0';
+    }
+
+    int32_t toInt(double value)
+    {
+        return static_cast<int32_t>(value < 0 ? value - 0.5 : value + 0.5);
+    }
+
+    // "118.700" to 118700
+    int32_t parseFrequency(std::string_view text)
+    {
+        double megahertz = 0.0;
+        if (std::from_chars(text.data(), text.data() + text.size(), megahertz).ec != std::errc()) return 0;
+        return toInt(megahertz * 1000.0);
+    }
+
+    template <typename Field>
+    void forEachMember(JsonScanner& scanner, Field&& field)
+    {
+        scanner.expect('{');
+        bool first = true;
+        while (scanner.nextMember(first, '}')) {
+            std::string_view key = scanner.readString();
+            scanner.expect(':');
+            field(key);
+        }
+    }
+
+    template <typename Element>
+    void forEachElement(JsonScanner& scanner, Element&& element)
+    {
+        if (scanner.readNull()) return;
+        scanner.expect('[');
+        bool first = true;
+        while (scanner.nextMember(first, ']')) element();
+    }
+}
+
+bool VatsimFeed::parse(std::string_view json)
+{
+    pilots_.clear();
+    controllers_.clear();
+    timestampMs_ = 0;
+    error_.clear();
+
+    JsonScanner scanner(json.data(), json.data() + json.size());
+    try {
+        forEachMember(scanner, [&](std::string_view section) {
+            if (section == "general") {
+                forEachMember(scanner, [&](std::string_view key) {
+                    if (key == "update_timestamp") timestampMs_ = std::max<int64_t>(0, parseTimestamp(scanner.readString()));
+                    else scanner.skipValue();
+                });
+            }
+            else if (section == "pilots") {
+                forEachElement(scanner, [&] {
+                    Pilot& pilot = pilots_.emplace_back();
+                    forEachMember(scanner, [&](std::string_view key) {
+                        if (key == "callsign") copyCallsign(pilot.callsign, scanner.readString());
+                        else if (key == "latitude") pilot.latitude = scanner.readNumber();
+                        else if (key == "longitude") pilot.longitude = scanner.readNumber();
+                        else if (key == "altitude") pilot.altitude = toInt(scanner.readNumber());
+                        else if (key == "groundspeed") pilot.groundSpeed = toInt(scanner.readNumber());
+                        else scanner.skipValue();
+                    });
+                });
+            }
+            else if (section == "controllers") {
+                forEachElement(scanner, [&] {
+                    Controller& controller = controllers_.emplace_back();
+                    forEachMember(scanner, [&](std::string_view key) {
+                        if (key == "callsign") copyCallsign(controller.callsign, scanner.readString());
+                        else if (key == "frequency") controller.frequencyKhz = parseFrequency(scanner.readString());
+                        else if (key == "facility") controller.facility = toInt(scanner.readNumber());
+                        else if (key == "rating") controller.rating = toInt(scanner.readNumber());
+                        else if (key == "visual_range") controller.visualRange = toInt(scanner.readNumber());
+                        else scanner.skipValue();
+                    });
+                });
+            }
+            else scanner.skipValue();
+        });
+        if (!scanner.atEnd()) throw MalformedJson();
+    }
+    catch (const MalformedJson&) {
+        error_ = "malformed JSON near offset " + std::to_string(scanner.position() - json.data());
+        pilots_.clear();
+        controllers_.clear();
+        return false;
+    }
+    return true;
+}
+
+int64_t VatsimFeed::parseTimestamp(std::string_view text)
+{
+    // YYYY-MM-DDTHH:MM:SS[.fraction]Z
+    auto number = [&](size_t offset, size_t length) {
+        int value = 0;
+        if (offset + length > text.size()) return -1;
+        for (size_t i = offset; i < offset + length; ++i) {
+            if (text[i] < '0' || text[i] > '9') return -1;
+            value = value * 10 + (text[i] - '0');
+        }
+        return value;
+    };
+    int year = number(0, 4), month = number(5, 2), day = number(8, 2);
+    int hour = number(11, 2), minute = number(14, 2), second = number(17, 2);
+    if (year < 0 || month < 1 || month > 12 || day < 1 || hour < 0 || minute < 0 || second < 0) return -1;
+
+    int milliseconds = 0;
+    if (text.size() > 19 && text[19] == '.') {
+        for (size_t i = 20, digits = 0; i < text.size() && digits < 3 && text[i] >= '0' && text[i] <= '9'; ++i, ++digits)
+            milliseconds += (text[i] - '0') * (digits == 0 ? 100 : digits == 1 ? 10 : 1);
+    }
+
+    // Days from civil date, proleptic Gregorian calendar
+    int y = year - (month <= 2 ? 1 : 0);
+    int era = (y >= 0 ? y : y - 399) / 400;
+    int yearOfEra = y - era * 400;
+    int dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    int64_t days = static_cast<int64_t>(era) * 146097 + dayOfEra - 719468;
+
+    return ((days * 24 + hour) * 60 + minute) * 60000 + second * 1000 + milliseconds;
+}
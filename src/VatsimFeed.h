@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace rpc {
+    // Reader for VATSIM network data feed snapshots (the v3 JSON of data.vatsim.net). A single
+    // pass scanner pulls the few pilot and controller fields the plugin uses and skips everything
+    // else - flight plans, ATIS text, servers, prefiles - with SSE2 block scans for quotes and
+    // brackets instead of tokenizing them.
+    class VatsimFeed
+    {
+    public:
+        struct Pilot {
+            char callsign[16] = {};
+            double latitude = 0.0;
+            double longitude = 0.0;
+            int32_t altitude = 0;    // feet
+            int32_t groundSpeed = 0; // knots
+        };
+
+        struct Controller {
+            char callsign[16] = {};
+            int32_t frequencyKhz = 0;
+            int32_t facility = 0;    // same codes as EuroScope, 0 for observers
+            int32_t rating = 0;
+            int32_t visualRange = 0; // nm
+        };
+
+        // Replaces the current content, false with getError() set when the JSON is malformed
+        bool parse(std::string_view json);
+
+        const std::vector<Pilot>& getPilots() const { return pilots_; }
+        const std::vector<Controller>& getControllers() const { return controllers_; }
+        int64_t getTimestampMs() const { return timestampMs_; } // general.update_timestamp, 0 if missing
+        const std::string& getError() const { return error_; }
+
+        // "2024-05-04T12:34:56.1234567Z" to unix milliseconds, -1 when not in that form
+        static int64_t parseTimestamp(std::string_view text);
+
+    private:
+        std::vector<Pilot> pilots_;
+        std::vector<Controller> controllers_;
+        int64_t timestampMs_ = 0;
+        std::string error_;
+    };
+} // namespace rpc
@@ -0,0 +1,43 @@
+#include "VoiceStats.h"
+#include <algorithm>
+#include <bit>
+
+using namespace rpc;
+
+void VoiceStats::transmitEnded()
+{
+    // A missed start (plugin loaded mid transmission) is not counted
+    int64_t start = transmitStart_.exchange(0, std::memory_order_relaxed);
+    if (start == 0) return;
+
+    uint64_t duration = static_cast<uint64_t>(std::max<int64_t>(now() - start, 0));
+    transmissions_.fetch_add(1, std::memory_order_relaxed);
+    airtimeMs_.fetch_add(duration, std::memory_order_relaxed);
+    lengths_[bucketFor(duration)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void VoiceStats::reset()
+{
+    transmitStart_ = 0;
+    transmissions_ = 0;
+    airtimeMs_ = 0;
+    receptions_ = 0;
+    for (auto& bucket : lengths_) bucket = 0;
+}
+
+VoiceStats::Summary VoiceStats::getSummary() const
+{
+    Summary summary;
+    summary.transmissions = transmissions_.load(std::memory_order_relaxed);
+    summary.airtimeMs = airtimeMs_.load(std::memory_order_relaxed);
+    summary.receptions = receptions_.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < HISTOGRAM_BUCKETS; ++i)
+        summary.lengths[i] = lengths_[i].load(std::memory_order_relaxed);
+    return summary;
+}
+
+size_t VoiceStats::bucketFor(uint64_t durationMs)
+{
+    size_t bucket = static_cast<size_t>(std::bit_width(durationMs / 500));
+    return bucket < HISTOGRAM_BUCKETS ? bucket : HISTOGRAM_BUCKETS - 1;
+}
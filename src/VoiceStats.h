@@ -0,0 +1,47 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace rpc {
+    // Lock free radio statistics. The voice callbacks fire from EuroScope's audio thread at radio
+    // rate, so recording is one steady_clock read plus a handful of relaxed atomic operations.
+    class VoiceStats
+    {
+    public:
+        // Transmission lengths, log2 buckets of half a second: <0.5s, <1s, <2s, <4s, <8s, <16s, <32s, longer
+        static constexpr size_t HISTOGRAM_BUCKETS = 8;
+
+        struct Summary {
+            uint64_t transmissions = 0;
+            uint64_t airtimeMs = 0;
+            uint64_t receptions = 0;
+            std::array<uint32_t, HISTOGRAM_BUCKETS> lengths{};
+        };
+
+        void transmitStarted() { transmitStart_.store(now(), std::memory_order_relaxed); }
+        void transmitEnded();
+        void receiveStarted() { receptions_.fetch_add(1, std::memory_order_relaxed); }
+        void reset();
+
+        uint64_t getTransmissions() const { return transmissions_.load(std::memory_order_relaxed); }
+        Summary getSummary() const;
+
+        static size_t bucketFor(uint64_t durationMs);
+
+    private:
+        static int64_t now()
+        {
+            return std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+    private:
+        std::atomic<int64_t> transmitStart_{ 0 };
+        std::atomic<uint64_t> transmissions_{ 0 };
+        std::atomic<uint64_t> airtimeMs_{ 0 };
+        std::atomic<uint64_t> receptions_{ 0 };
+        std::array<std::atomic<uint32_t>, HISTOGRAM_BUCKETS> lengths_{};
+    };
+} // namespace rpc
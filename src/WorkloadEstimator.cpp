@@ -0,0 +1,69 @@
+#include "WorkloadEstimator.h"
+#include <cmath>
+
+using namespace rpc;
+
+WorkloadEstimator::WorkloadEstimator(double onThreshold, double offThreshold)
+    : onThreshold_(onThreshold), offThreshold_(offThreshold)
+{
+}
+
+bool WorkloadEstimator::update(int64_t nowSeconds)
+{
+    if (lastUpdate_ == 0) {
+        lastUpdate_ = nowSeconds;
+        trackedAverage_ = tracked_.load(std::memory_order_relaxed);
+    }
+    if (nowSeconds <= lastUpdate_) return false;
+
+    double elapsed = static_cast<double>(nowSeconds - lastUpdate_);
+    lastUpdate_ = nowSeconds;
+
+    double perMinute = 60.0 / elapsed;
+    double newTracks = newTracks_.exchange(0, std::memory_order_relaxed) * perMinute;
+    double handoffs = handoffs_.exchange(0, std::memory_order_relaxed) * perMinute;
+    double instructions = instructions_.exchange(0, std::memory_order_relaxed) * perMinute;
+    double messages = messages_.exchange(0, std::memory_order_relaxed) * perMinute;
+
+    double trackedAlpha = smoothing(elapsed, TRACKED_TIME_CONSTANT);
+    double rateAlpha = smoothing(elapsed, RATE_TIME_CONSTANT);
+    trackedAverage_ += trackedAlpha * (tracked_.load(std::memory_order_relaxed) - trackedAverage_);
+    newTrackRate_ += rateAlpha * (newTracks - newTrackRate_);
+    handoffRate_ += rateAlpha * (handoffs - handoffRate_);
+    instructionRate_ += rateAlpha * (instructions - instructionRate_);
+    messageRate_ += rateAlpha * (messages - messageRate_);
+
+    double score = weights_.tracked * trackedAverage_
+        + weights_.newTracks * newTrackRate_
+        + weights_.handoffs * handoffRate_
+        + weights_.instructions * instructionRate_
+        + weights_.messages * messageRate_;
+    score_.store(score, std::memory_order_relaxed);
+
+    bool onFire = onFire_.load(std::memory_order_relaxed);
+    bool next = onFire ? score >= offThreshold_ : score >= onThreshold_;
+    onFire_.store(next, std::memory_order_relaxed);
+    return next != onFire;
+}
+
+void WorkloadEstimator::reset()
+{
+    newTracks_ = 0;
+    handoffs_ = 0;
+    instructions_ = 0;
+    messages_ = 0;
+    tracked_ = 0;
+    lastUpdate_ = 0;
+    trackedAverage_ = 0.0;
+    newTrackRate_ = 0.0;
+    handoffRate_ = 0.0;
+    instructionRate_ = 0.0;
+    messageRate_ = 0.0;
+    score_ = 0.0;
+    onFire_ = false;
+}
+
+double WorkloadEstimator::smoothing(double elapsedSeconds, double timeConstantSeconds)
+{
+    return 1.0 - std::exp(-elapsedSeconds / timeConstantSeconds);
+}
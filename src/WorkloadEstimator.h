@@ -0,0 +1,64 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+namespace rpc {
+    // Composite workload score blending exponentially weighted moving averages of the tracked count
+    // and of event rates (new tracks, handoffs, instructions, text messages). Events are plain counter
+    // bumps; each update() folds them into the averages in O(1). The "on fire" flag uses hysteresis so
+    // it only follows sustained load.
+    class WorkloadEstimator
+    {
+    public:
+        struct Weights {
+            double tracked = 1.0;       // per aircraft tracked
+            double newTracks = 2.0;     // per new track per minute
+            double handoffs = 2.0;      // per handoff per minute
+            double instructions = 0.5;  // per instruction per minute
+            double messages = 0.5;      // per text message per minute
+        };
+
+        WorkloadEstimator(double onThreshold, double offThreshold);
+
+        // Any thread
+        void recordNewTrack(uint32_t count = 1) { newTracks_.fetch_add(count, std::memory_order_relaxed); }
+        void recordHandoff(uint32_t count = 1) { handoffs_.fetch_add(count, std::memory_order_relaxed); }
+        void recordInstruction(uint32_t count = 1) { instructions_.fetch_add(count, std::memory_order_relaxed); }
+        void recordMessage(uint32_t count = 1) { messages_.fetch_add(count, std::memory_order_relaxed); }
+        void setTracked(uint32_t tracked) { tracked_.store(tracked, std::memory_order_relaxed); }
+
+        // Folds pending events into the averages, returns true when the on fire flag changed. Single thread.
+        bool update(int64_t nowSeconds);
+        void reset();
+
+        double getScore() const { return score_.load(std::memory_order_relaxed); }
+        bool isOnFire() const { return onFire_.load(std::memory_order_relaxed); }
+
+    private:
+        static double smoothing(double elapsedSeconds, double timeConstantSeconds);
+
+    private:
+        static constexpr double TRACKED_TIME_CONSTANT = 120.0; // seconds
+        static constexpr double RATE_TIME_CONSTANT = 300.0;
+
+        Weights weights_;
+        double onThreshold_;
+        double offThreshold_;
+
+        std::atomic<uint32_t> newTracks_{ 0 };
+        std::atomic<uint32_t> handoffs_{ 0 };
+        std::atomic<uint32_t> instructions_{ 0 };
+        std::atomic<uint32_t> messages_{ 0 };
+        std::atomic<uint32_t> tracked_{ 0 };
+
+        int64_t lastUpdate_ = 0;
+        double trackedAverage_ = 0.0;
+        double newTrackRate_ = 0.0;   // per minute
+        double handoffRate_ = 0.0;
+        double instructionRate_ = 0.0;
+        double messageRate_ = 0.0;
+
+        std::atomic<double> score_{ 0.0 };
+        std::atomic<bool> onFire_{ false };
+    };
+} // namespace rpc
@@ -0,0 +1,57 @@
+// Prints a flight recorder dump written by ".rpc dump" or at plugin shutdown, one event per line
+// with its UTC wall clock time and the delay since the previous event.
+//
+//     rpc-blackbox EuroscopeRPC-last.blackbox
+#include <cstdio>
+#include <ctime>
+#include <vector>
+#include "FlightRecorder.h"
+
+using namespace rpc;
+
+int main(int argc, char** argv)
+{
+    if (argc != 2) {
+        std::fprintf(stderr, "usage: %s <dump.blackbox>\n", argv[0]);
+        return 2;
+    }
+
+    FlightRecorder::FileHeader header{};
+    std::vector<FlightRecorder::Event> events;
+    switch (FlightRecorder::load(argv[1], header, events)) {
+    case FlightRecorder::LoadResult::UNREADABLE:
+        std::perror(argv[1]);
+        return 1;
+    case FlightRecorder::LoadResult::NOT_A_DUMP:
+        std::fprintf(stderr, "%s: not a flight recorder dump\n", argv[1]);
+        return 1;
+    case FlightRecorder::LoadResult::UNSUPPORTED_VERSION:
+        std::fprintf(stderr, "%s: unsupported version %u\n", argv[1], header.version);
+        return 1;
+    case FlightRecorder::LoadResult::TRUNCATED:
+        std::fprintf(stderr, "%s: truncated, %zu of %u events\n", argv[1], events.size(), header.count);
+        break;
+    case FlightRecorder::LoadResult::OK:
+        break;
+    }
+
+    uint64_t previous = events.empty() ? 0 : events.front().timestamp;
+    for (const FlightRecorder::Event& event : events) {
+        // Event timestamps are steady clock, anchored to the wall clock sampled at dump time
+        int64_t wallNs = header.wallClockNs - static_cast<int64_t>(header.steadyNs - event.timestamp);
+        std::time_t seconds = static_cast<std::time_t>(wallNs / 1000000000);
+        std::tm utc{};
+#ifdef _WIN32
+        gmtime_s(&utc, &seconds);
+#else
+        gmtime_r(&seconds, &utc);
+#endif
+        char time[32];
+        std::strftime(time, sizeof(time), "%Y-%m-%d %H:%M:%S", &utc);
+
+        std::printf("%s.%06lldZ %+10.3f ms  %-20s %s\n", time, static_cast<long long>(wallNs % 1000000000 / 1000),
+            static_cast<double>(event.timestamp - previous) / 1e6, FlightRecorder::typeName(event.type), FlightRecorder::describe(event).c_str());
+        previous = event.timestamp;
+    }
+    return 0;
+}
@@ -0,0 +1,1188 @@
+// Checks of the portable modules the plugin is built from, the parts that compile without the
+// EuroScope SDK. Run by ctest; a name filter runs only the matching tests.
+//
+//     rpc-core-tests [filter]
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "BadgeEngine.h"
+#include "CommsStats.h"
+#include "ControlTimeStats.h"
+#include "ControllerRegistry.h"
+#include "FlightRecorder.h"
+#include "Geo.h"
+#include "GeoBatch.h"
+#include "HandoffTracker.h"
+#include "LatencyHistogram.h"
+#include "MessageQueue.h"
+#include "MetarCache.h"
+#include "MovementCounters.h"
+#include "PresenceCadence.h"
+#include "RunwayCache.h"
+#include "SectorForecast.h"
+#include "Seqlock.h"
+#include "SessionReader.h"
+#include "SessionRecorder.h"
+#include "SessionTracks.h"
+#include "SlidingWindowLimit.h"
+#include "TargetGrid.h"
+#include "VatsimFeed.h"
+#include "VoiceStats.h"
+#include "WorkloadEstimator.h"
+
+using namespace rpc;
+
+namespace {
+    int failures = 0;
+
+    void check(bool condition, const char* expression, const char* file, int line)
+    {
+        if (condition) return;
+        ++failures;
+        std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+    }
+
+#define CHECK(condition) check((condition), #condition, __FILE__, __LINE__)
+
+    // Fresh file name in the temporary directory, removed when done
+    class TemporaryFile
+    {
+    public:
+        explicit TemporaryFile(const char* name) : path_((std::filesystem::temp_directory_path() / name).string())
+        {
+            std::filesystem::remove(path_);
+        }
+        ~TemporaryFile() { std::filesystem::remove(path_); }
+        const std::string& path() const { return path_; }
+
+    private:
+        std::string path_;
+    };
+
+    void histogramBuckets()
+    {
+        // Every bucket covers the values that map to it, without gaps nor overlaps
+        for (size_t bucket = 0; bucket < LatencyHistogram::BUCKETS; ++bucket) {
+            uint64_t lower = LatencyHistogram::lowerBound(bucket);
+            uint64_t upper = LatencyHistogram::upperBound(bucket);
+            CHECK(lower <= upper);
+            CHECK(LatencyHistogram::bucketFor(lower) == bucket);
+            CHECK(LatencyHistogram::bucketFor(upper) == bucket);
+            if (bucket + 1 < LatencyHistogram::BUCKETS) CHECK(LatencyHistogram::lowerBound(bucket + 1) == upper + 1);
+            // Relative width within 1/16 above the exact range
+            if (lower >= 2 * LatencyHistogram::SUB_BUCKET_HALF) CHECK((upper - lower + 1) * LatencyHistogram::SUB_BUCKET_HALF <= lower);
+        }
+        CHECK(LatencyHistogram::upperBound(LatencyHistogram::BUCKETS - 1) == LatencyHistogram::MAX_VALUE);
+        CHECK(LatencyHistogram::bucketFor(LatencyHistogram::MAX_VALUE + 1000) == LatencyHistogram::BUCKETS - 1);
+    }
+
+    void histogramPercentiles()
+    {
+        LatencyHistogram histogram;
+        CHECK(histogram.percentile(0.5) == 0);
+        for (uint64_t value = 1; value <= 1000; ++value) histogram.record(value);
+        CHECK(histogram.getCount() == 1000);
+        CHECK(histogram.getMax() == 1000);
+        CHECK(histogram.getMean() == 500.5);
+        // Upper bound of the bucket, within 1/16 of the exact value and never above the max
+        uint64_t p50 = histogram.percentile(0.5), p90 = histogram.percentile(0.9);
+        CHECK(p50 >= 500 && p50 <= 500 + 500 / 16);
+        CHECK(p90 >= 900 && p90 <= 900 + 900 / 16);
+        CHECK(histogram.percentile(1.0) == 1000);
+        CHECK(histogram.percentile(0.0) == 1);
+
+        histogram.reset();
+        CHECK(histogram.getCount() == 0 && histogram.getMax() == 0);
+    }
+
+    void histogramMerge()
+    {
+        LatencyHistogram a, b;
+        for (uint64_t value = 0; value < 100; ++value) a.record(value);
+        b.record(5000, 100);
+        a.merge(b);
+        CHECK(a.getCount() == 200);
+        CHECK(a.getMax() == 5000);
+        CHECK(a.percentile(0.25) < 100);
+        CHECK(a.percentile(0.75) >= 5000);
+
+        LatencyHistogram::Snapshot snapshot = a.snapshot();
+        LatencyHistogram copy;
+        copy.merge(snapshot);
+        for (size_t bucket = 0; bucket < LatencyHistogram::BUCKETS; ++bucket) CHECK(copy.getBucketCount(bucket) == a.getBucketCount(bucket));
+        CHECK(copy.getMean() == a.getMean());
+    }
+
+    void controlTimeRoundTrip()
+    {
+        TemporaryFile file("rpc-core-tests-control-times.bin");
+        ControlTimeStats first;
+        for (uint64_t minutes = 1; minutes <= 100; ++minutes) first.record("EDDF_TWR", minutes * 60);
+        first.record("EDDF_APP", 3600);
+        first.record("", 30); // no callsign, session only
+        CHECK(first.getSession().getCount() == 102);
+        CHECK(first.getSessionPositions().size() == 2);
+        CHECK(first.save(file.path()));
+
+        // Earlier sessions merge with the current one, and survive another save
+        ControlTimeStats second;
+        CHECK(second.load(file.path()));
+        CHECK(second.getSession().getCount() == 0);
+        second.record("EDDF_TWR", 7200);
+        LatencyHistogram tower;
+        second.allTime("EDDF_TWR", tower);
+        CHECK(tower.getCount() == 101);
+        CHECK(tower.getMax() == 7200);
+        CHECK(second.save(file.path()));
+
+        ControlTimeStats third;
+        CHECK(third.load(file.path()));
+        LatencyHistogram towerAgain, approach;
+        third.allTime("EDDF_TWR", towerAgain);
+        third.allTime("EDDF_APP", approach);
+        CHECK(towerAgain.getCount() == 101);
+        CHECK(towerAgain.percentile(0.5) == tower.percentile(0.5));
+        CHECK(approach.getCount() == 1);
+
+        // A damaged file is refused and leaves the loaded figures alone
+        if (FILE* damaged = std::fopen(file.path().c_str(), "r+b")) {
+            std::fputc('X', damaged);
+            std::fclose(damaged);
+        }
+        CHECK(!third.load(file.path()));
+        LatencyHistogram stillThere;
+        third.allTime("EDDF_TWR", stillThere);
+        CHECK(stillThere.getCount() == 101);
+        CHECK(!third.load(file.path() + ".missing"));
+    }
+
+    void durationText()
+    {
+        CHECK(ControlTimeStats::formatDuration(45) == "45s");
+        CHECK(ControlTimeStats::formatDuration(12 * 60 + 59) == "12m");
+        CHECK(ControlTimeStats::formatDuration(3600 + 5 * 60) == "1h05");
+    }
+
+    // Presence thread passes per minute over a stretch where nothing changes, starting with the
+    // pass that sent the last change
+    double wakeupsPerMinute(bool idle, uint32_t instances, int64_t minutes)
+    {
+        PresenceCadence cadence;
+        int64_t elapsedMs = 0;
+        uint64_t wakeups = 0;
+        for (bool settled = false; elapsedMs < minutes * 60000; settled = true) {
+            ++wakeups;
+            int64_t wait = cadence.next(settled, false, idle, instances);
+            if (wait == PRESENCE_PARKED) break;
+            elapsedMs += wait;
+        }
+        return static_cast<double>(wakeups) / minutes;
+    }
+
+    void presenceCadence()
+    {
+        constexpr double MAX_IDLE_WAKEUPS_PER_MINUTE = 1.0;
+        CHECK(wakeupsPerMinute(true, 1, 10) <= MAX_IDLE_WAKEUPS_PER_MINUTE);
+        // Connected but quiet: backed off to the longest interval
+        CHECK(wakeupsPerMinute(false, 1, 10) <= 60000.0 / PRESENCE_INTERVAL_MAX_MS + 1.0);
+        // Another instance publishes without waking the leader, it keeps the shortest interval
+        CHECK(wakeupsPerMinute(true, 2, 10) == 60000.0 / PRESENCE_INTERVAL_MIN_MS);
+
+        // A change brings the interval straight back down
+        PresenceCadence cadence;
+        for (int pass = 0; pass < 10; ++pass) cadence.next(true, false, false, 1);
+        CHECK(cadence.next(true, false, false, 1) == PRESENCE_INTERVAL_MAX_MS);
+        CHECK(cadence.next(false, true, false, 1) <= PRESENCE_INTERVAL_MAX_MS / 2);
+        CHECK(cadence.next(false, false, true, 1) != PRESENCE_PARKED);
+    }
+
+    void badgeRuleErrors()
+    {
+        BadgeEngine engine;
+        std::string error;
+        CHECK(engine.compile(BadgeEngine::DEFAULT_RULES, error));
+        CHECK(error.empty());
+        CHECK(engine.getBadges().size() == 5);
+
+        // Refused rules name their line and keep the rules compiled before
+        CHECK(!engine.compile("# comment\nfoo tracks 10 Ten\nbar flights 3 Three\n", error));
+        CHECK(error == "line 3: unknown counter \"flights\"");
+        CHECK(engine.getBadges().size() == 5);
+        CHECK(!engine.compile("a tracks 0 Zero", error));
+        CHECK(error == "line 1: bad threshold");
+        CHECK(!engine.compile("a tracks 12x Twelve", error));
+        CHECK(error == "line 1: bad threshold");
+        CHECK(!engine.compile("a tracks 12", error));
+        CHECK(error == "line 1: missing title");
+        CHECK(!engine.compile("a tracks 1 One\r\na sweatbox 1 Again\r\n", error));
+        CHECK(error == "line 2: duplicate id");
+
+        // Blank lines, comments and Windows line ends are fine, the title keeps its spaces
+        CHECK(engine.compile("\n  # only a comment\r\nfirst-fire  on-fire   1   First time on fire\r\n", error));
+        CHECK(error.empty());
+        CHECK(engine.getBadges().size() == 1);
+        CHECK(engine.getBadges()[0].title == "First time on fire");
+        CHECK(engine.getBadges()[0].counter == BadgeEngine::Counter::ON_FIRE);
+    }
+
+    void badgeUnlocks()
+    {
+        TemporaryFile file("rpc-core-tests-badges.unlocked");
+        BadgeEngine engine;
+        std::string error;
+        CHECK(engine.compile("b50 tracks 50 Fifty\nb10 tracks 10 Ten\nb100 tracks 100 Hundred\nsb sweatbox 1 Sweatbox\n", error));
+
+        std::string unlocked;
+        auto sink = [&unlocked](const BadgeEngine::Badge& badge) { unlocked += badge.id + " "; };
+        for (uint64_t tracks = 1; tracks <= 60; ++tracks) engine.update(BadgeEngine::Counter::SESSION_TRACKS, tracks, 1000 + tracks, sink);
+        // In threshold order, once each, other counters untouched
+        CHECK(unlocked == "b10 b50 ");
+        CHECK(engine.getValue(BadgeEngine::Counter::SESSION_TRACKS) == 60);
+        // Each counter only reaches its own rules, a jump past the threshold unlocks too
+        unlocked.clear();
+        engine.update(BadgeEngine::Counter::SWEATBOX_CONNECTIONS, 3, 2000, sink);
+        CHECK(unlocked == "sb ");
+        CHECK(engine.saveUnlocked(file.path()));
+
+        // Unlocks survive a restart and a rule change; new rules still unlock
+        BadgeEngine restarted;
+        CHECK(restarted.loadUnlocked(file.path()));
+        CHECK(restarted.compile("b10 tracks 10 Ten\nb20 tracks 20 Twenty\n", error));
+        CHECK(restarted.getBadges()[0].unlockedAt == 1010);
+        unlocked.clear();
+        restarted.update(BadgeEngine::Counter::SESSION_TRACKS, 25, 3000, [&](const BadgeEngine::Badge& badge) { unlocked += badge.id + " "; });
+        CHECK(unlocked == "b20 ");
+        CHECK(restarted.saveUnlocked(file.path()));
+
+        // Ids of rules no longer defined are kept in the file
+        BadgeEngine again;
+        CHECK(again.loadUnlocked(file.path()));
+        CHECK(again.compile("sb sweatbox 1 Sweatbox\nb50 tracks 50 Fifty\n", error));
+        CHECK(again.getBadges()[0].unlockedAt == 2000);
+        CHECK(again.getBadges()[1].unlockedAt == 1050);
+    }
+
+    void handoffTracking()
+    {
+        HandoffTracker handoffs;
+        PackedCallsign inbound = packCallsign("BAW12");
+        PackedCallsign outbound = packCallsign("KLM34");
+
+        // Offered to me, then accepted: one inbound handoff
+        CHECK(handoffs.update(inbound, false, true, true) == 0);
+        CHECK(handoffs.getCounters().inboundPending == 1);
+        CHECK(handoffs.update(inbound, false, true, true) == 0); // same data again
+        CHECK(handoffs.update(inbound, true, false, false) == 1);
+        CHECK(handoffs.isTrackedByMe(inbound));
+
+        // Mine, offered away, then taken: one outbound handoff
+        CHECK(handoffs.update(outbound, true, false, false) == 0);
+        CHECK(handoffs.update(outbound, true, true, false) == 0);
+        CHECK(handoffs.getCounters().outboundPending == 1);
+        CHECK(handoffs.update(outbound, false, false, false) == 1);
+        CHECK(!handoffs.isTrackedByMe(outbound));
+
+        // An offer withdrawn is no handoff, and a dropped flight plan clears its gauge
+        PackedCallsign withdrawn = packCallsign("DLH56");
+        CHECK(handoffs.update(withdrawn, false, true, true) == 0);
+        CHECK(handoffs.update(withdrawn, false, false, false) == 0);
+        CHECK(handoffs.update(withdrawn, false, true, true) == 0);
+        handoffs.remove(withdrawn);
+
+        HandoffTracker::Counters counters = handoffs.getCounters();
+        CHECK(counters.inbound == 1 && counters.outbound == 1);
+        CHECK(counters.inboundOffered == 3 && counters.outboundInitiated == 1);
+        CHECK(counters.inboundPending == 0 && counters.outboundPending == 0);
+
+        handoffs.reset();
+        CHECK(handoffs.getInbound() == 0 && !handoffs.isTrackedByMe(inbound));
+    }
+
+    void messageQueue()
+    {
+        // 5 messages at once then one every 2 seconds, identical ones counted once per 30 seconds
+        MessageQueue queue(30, 5, 2);
+        std::vector<std::string> shown;
+        auto sink = [&](const std::string& sender, const std::string& text) { shown.push_back(sender + ": " + text); };
+
+        for (int i = 0; i < 8; ++i) CHECK(queue.push("Error", "message " + std::to_string(i), 100));
+        CHECK(!queue.push("Error", "message 7", 110));
+        queue.drain(100, sink);
+        CHECK(shown.size() == 5 && shown.front() == "Error: message 0" && shown.back() == "Error: message 4");
+        CHECK(queue.getDropped() == 3 && queue.getDuplicates() == 1);
+
+        // The summary waits for the next token
+        queue.drain(101, sink);
+        CHECK(shown.size() == 5);
+        queue.drain(102, sink);
+        CHECK(shown.size() == 6 && shown.back() == "Status: 4 repeated or excess messages suppressed");
+        CHECK(queue.getDropped() == 0 && queue.getDuplicates() == 0);
+
+        // Tokens come back one per refill interval, up to the burst
+        for (int i = 0; i < 8; ++i) queue.push("Info", "later " + std::to_string(i), 200);
+        queue.drain(200, sink);
+        CHECK(shown.size() == 11);
+        CHECK(queue.push("Error", "message 7", 140)); // out of the dedupe window
+    }
+
+    void metarParsing()
+    {
+        Metar metar;
+        CHECK(parseMetar("METAR LFPG 181030Z 25012G22KT 9999 FEW020 BKN035 14/09 Q1013 NOSIG=", metar));
+        CHECK(std::strcmp(metar.station, "LFPG") == 0);
+        CHECK(metar.windDirection == 250 && metar.windSpeed == 12 && metar.windGust == 22);
+        CHECK(metar.visibility == 9999 && metar.ceiling == 3500);
+        CHECK(metar.hasTemperature && metar.temperature == 14 && metar.dewpoint == 9);
+        CHECK(metar.qnh == 1013);
+        CHECK(metar.category == FlightCategory::VFR);
+        CHECK(formatMetar(metar) == "Q1013, wind 250/12G22");
+
+        // Statute miles, altimeter in inches, below minima
+        CHECK(parseMetar("KJFK 181051Z VRB03KT 1 1/2SM BR OVC004 M01/M02 A2992", metar));
+        CHECK(metar.windDirection == -1 && metar.windSpeed == 3);
+        CHECK(metar.visibility == 2414 && metar.ceiling == 400);
+        CHECK(metar.temperature == -1 && metar.dewpoint == -2);
+        CHECK(metar.qnh == 1013);
+        CHECK(metar.category == FlightCategory::LIFR);
+        CHECK(formatMetar(metar) == "Q1013, wind VRB/3");
+
+        CHECK(parseMetar("EGLL 181020Z 05008KT CAVOK 12/04 Q1030 TEMPO 3000 BR", metar));
+        CHECK(metar.visibility == 9999 && metar.ceiling == -1 && metar.category == FlightCategory::VFR);
+
+        CHECK(!parseMetar("", metar));
+        CHECK(!parseMetar("NOT A METAR", metar));
+    }
+
+    void metarCache()
+    {
+        static MetarCache cache; // a thousand seqlocked slots, too large for the stack
+        CHECK(!cache.find("LFPG"));
+        CHECK(cache.update("LFPG", "LFPG 181030Z 25012KT 9999 BKN035 14/09 Q1013", 100));
+        CHECK(cache.update("", "EDDF 181020Z 27005KT 9999 FEW040 12/06 Q1021", 100)); // keyed by the report station
+        CHECK(!cache.update("LFPO", "garbage", 100));
+        CHECK(cache.size() == 2);
+
+        CHECK(cache.update("lfpg", "LFPG 181100Z 26015KT 9999 OVC008 14/12 Q1011", 1900)); // replaces, same key
+        CHECK(cache.size() == 2);
+        std::optional<Metar> paris = cache.find("LFPG");
+        CHECK(paris && paris->qnh == 1011 && paris->received == 1900);
+        CHECK(paris && paris->category == FlightCategory::IFR);
+        std::optional<Metar> frankfurt = cache.find("eddf");
+        CHECK(frankfurt && frankfurt->qnh == 1021);
+        CHECK(!cache.find("LFP"));
+    }
+
+    void movementStateMachine()
+    {
+        using Movement = MovementCounters::Movement;
+        using Ground = MovementCounters::GroundState;
+        MovementCounters movements;
+        PackedCallsign departure = packCallsign("AFR1234");
+        PackedCallsign arrival = packCallsign("DLH5X");
+
+        // Nothing is known about a radar target until its flight plan shows up
+        CHECK(movements.updateGroundSpeed(departure, 0) == 0);
+        // First sight sets the state without counting, even an aircraft already cleared and taxiing
+        CHECK(movements.updateFlightPlan(departure, Ground::TAXI, true) == 0);
+        CHECK(movements.updateFlightPlan(arrival, Ground::NONE, false) == 0);
+
+        PackedCallsign fresh = packCallsign("EZY12AB");
+        CHECK(movements.updateFlightPlan(fresh, Ground::NONE, false) == 0);
+        CHECK(movements.updateFlightPlan(fresh, Ground::NONE, true) == MovementCounters::bit(Movement::CLEARANCE));
+        CHECK(movements.updateFlightPlan(fresh, Ground::NONE, true) == 0); // same data again
+        CHECK(movements.updateFlightPlan(fresh, Ground::STARTUP, true) == 0);
+        CHECK(movements.updateFlightPlan(fresh, Ground::PUSH, true) == MovementCounters::bit(Movement::PUSHBACK));
+        CHECK(movements.updateFlightPlan(fresh, Ground::TAXI, true) == MovementCounters::bit(Movement::TAXI_OUT));
+        CHECK(movements.updateFlightPlan(fresh, Ground::DEPARTURE, true) == 0);
+
+        // Ground speed with hysteresis: the first sample sets the state, crossings count once
+        CHECK(movements.updateGroundSpeed(fresh, 15) == 0);
+        CHECK(movements.updateGroundSpeed(fresh, 45) == 0);
+        CHECK(movements.updateGroundSpeed(fresh, 140) == MovementCounters::bit(Movement::TAKEOFF));
+        CHECK(movements.updateGroundSpeed(fresh, 40) == 0);
+        CHECK(movements.updateGroundSpeed(fresh, 160) == 0);
+
+        CHECK(movements.updateGroundSpeed(arrival, 250) == 0);
+        CHECK(movements.updateGroundSpeed(arrival, 35) == 0);
+        CHECK(movements.updateGroundSpeed(arrival, 20) == MovementCounters::bit(Movement::LANDING));
+        CHECK(movements.updateFlightPlan(arrival, Ground::TAXI_IN, false) == MovementCounters::bit(Movement::TAXI_IN));
+
+        // A disconnected flight plan starts over
+        movements.remove(fresh);
+        CHECK(movements.updateGroundSpeed(fresh, 0) == 0);
+        CHECK(movements.updateFlightPlan(fresh, Ground::PUSH, true) == 0);
+
+        CHECK(MovementCounters::parseGroundState("TAXIIN") == Ground::TAXI_IN);
+        CHECK(MovementCounters::parseGroundState("DEPA") == Ground::DEPARTURE);
+        CHECK(MovementCounters::parseGroundState("") == Ground::NONE);
+        CHECK(MovementCounters::parseGroundState(nullptr) == Ground::NONE);
+        CHECK((MovementCounters::DEPARTURE_MOVEMENTS & MovementCounters::ARRIVAL_MOVEMENTS) == 0);
+        CHECK((MovementCounters::DEPARTURE_MOVEMENTS | MovementCounters::ARRIVAL_MOVEMENTS) == (1u << static_cast<int>(Movement::COUNT)) - 1);
+    }
+
+    void movementRates()
+    {
+        using Movement = MovementCounters::Movement;
+        MovementCounters movements;
+        movements.record(MovementCounters::DEPARTURE_MOVEMENTS, 1000);
+        movements.record(MovementCounters::bit(Movement::TAKEOFF), 1500);
+        CHECK(movements.perHour(Movement::TAKEOFF, 1500) == 2);
+        CHECK(movements.perHour(Movement::CLEARANCE, 1500) == 1);
+        CHECK(movements.perHour(Movement::LANDING, 1500) == 0);
+        // Out of the hour window
+        CHECK(movements.perHour(Movement::TAKEOFF, 1000 + 3600 + 60) == 1);
+        CHECK(movements.perHour(Movement::TAKEOFF, 1500 + 3600 + 60) == 0);
+    }
+
+    void runwayCache()
+    {
+        RunwayCache runways;
+        CHECK(runways.find("LFPG") == nullptr);
+        runways.add("LFPG Paris Charles de Gaulle", "27L");
+        runways.add(" LFPG", "26R");
+        runways.add("LFPG", "27L"); // active for departure and arrival
+        runways.add("LFPG", "");
+        runways.add("EGLL", "27R");
+        runways.add("EGLL", "27");   // not the same runway as 27R
+        CHECK(runways.size() == 2);
+        CHECK(std::strcmp(runways.find("LFPG"), "27L/26R") == 0);
+        CHECK(std::strcmp(runways.find("EGLL"), "27R/27") == 0);
+        CHECK(runways.find("LFPO") == nullptr);
+
+        // Longer lists stop at the last runway that fits
+        for (const char* runway : { "01L", "01R", "02L", "02R", "03L", "03R", "04L" }) runways.add("KORD", runway);
+        CHECK(std::strcmp(runways.find("KORD"), "01L/01R/02L/02R/03L/03R") == 0);
+
+        CHECK(RunwayCache::icaoOf("  EDDF Frankfurt") == "EDDF");
+        CHECK(RunwayCache::icaoOf("   ").empty());
+
+        // A large sector file: 5000 runway ends over 1250 airports, each rebuild starts from clear().
+        // rpc-runway-bench times the same rebuild and lookups.
+        constexpr int AIRPORTS = 1250;
+        static const char* const ENDS[] = { "09L", "27R", "09R", "27L" };
+        char names[AIRPORTS][8];
+        for (int airport = 0; airport < AIRPORTS; ++airport) std::snprintf(names[airport], sizeof(names[airport]), "K%03d", airport);
+        for (int round = 0; round < 2; ++round) {
+            runways.clear();
+            CHECK(runways.size() == 0 && runways.find("KORD") == nullptr);
+            for (const char* end : ENDS)
+                for (int airport = 0; airport < AIRPORTS; ++airport) runways.add(names[airport], end);
+        }
+        CHECK(runways.size() == AIRPORTS);
+        CHECK(std::strcmp(runways.find("K617"), "09L/27R/09R/27L") == 0);
+        int found = 0;
+        for (const char* name : names) found += runways.find(name) != nullptr;
+        CHECK(found == AIRPORTS);
+    }
+
+    // Same sequence on every run, uniform in [0, 1)
+    class Random
+    {
+    public:
+        double next()
+        {
+            state_ = state_ * 6364136223846793005ull + 1442695040888963407ull;
+            return static_cast<double>(state_ >> 11) * (1.0 / 9007199254740992.0);
+        }
+        // Uniform over the sphere
+        double latitude() { return std::asin(next() * 2.0 - 1.0) / geo::DEG_TO_RAD; }
+        double longitude() { return next() * 360.0 - 180.0; }
+
+    private:
+        uint64_t state_ = 12345;
+    };
+
+    void geoBatchError()
+    {
+        // The batch kernel against the double haversine, through both dispatch paths, over references
+        // and points spread on the globe plus points within a degree of each reference's antipode
+        for (bool avx2 : { true, false }) {
+            if (avx2 && !geo::hasAvx2()) continue;
+            geo::setAvx2Enabled(avx2);
+            Random random;
+            geo::PointBatch batch;
+            float distances[1000];
+            double nearError = 0, anyError = 0;
+            for (int reference = 0; reference < 200; ++reference) {
+                double latitude = random.latitude(), longitude = random.longitude();
+                batch.clear();
+                for (int point = 0; point < 1000; ++point) {
+                    if (point % 4 == 0) batch.push_back(-latitude + random.next() * 2.0 - 1.0, longitude + 179.0 + random.next() * 2.0);
+                    else batch.push_back(random.latitude(), random.longitude());
+                }
+                batch.push_back(-latitude, longitude + 180.0); // exact antipode, within float rounding
+                geo::distancesNm(latitude, longitude, batch, distances);
+                for (size_t point = 0; point < batch.size(); ++point) {
+                    double exact = geo::distanceNm(latitude, longitude, batch.latitude(point), batch.longitude(point));
+                    double error = std::fabs(distances[point] - exact);
+                    if (exact < 3000) nearError = std::fmax(nearError, error);
+                    anyError = std::fmax(anyError, error);
+                }
+
+                // The chord comparison agrees with the distances away from the edge of the range
+                size_t inside = 0, edge = 0;
+                for (size_t point = 0; point < batch.size(); ++point) {
+                    double exact = geo::distanceNm(latitude, longitude, batch.latitude(point), batch.longitude(point));
+                    inside += exact < 3000;
+                    edge += std::fabs(exact - 3000) < 0.01;
+                }
+                size_t counted = geo::countWithin(latitude, longitude, batch, 3000);
+                CHECK(counted + edge >= inside && counted <= inside + edge);
+            }
+            CHECK(nearError < 0.001);
+            CHECK(anyError < 0.005);
+        }
+        geo::setAvx2Enabled(true);
+    }
+
+    void controllerNearby()
+    {
+        // The nearby count is the same whether controllers log on after my position is known or
+        // before it, including those right at the edge of the range
+        Random random;
+        ControllerRegistry before, after;
+        PackedCallsign self = packCallsign("LFFF_CTR");
+        constexpr double LATITUDE = 49.0, LONGITUDE = 2.5, RANGE_NM = 150.0;
+        before.setReference(self, LATITUDE, LONGITUDE, RANGE_NM);
+
+        geo::PointBatch positions;
+        for (int i = 0; i < 5000; ++i) {
+            ControllerRegistry::Controller controller;
+            char callsign[16];
+            std::snprintf(callsign, sizeof(callsign), "C%04d_APP", i);
+            controller.callsign = packCallsign(callsign);
+            controller.facility = 5;
+            // Half of them within the float error of the range, about 10 feet
+            double distance = i % 2 ? RANGE_NM + (random.next() - 0.5) * 0.004 : random.next() * 400.0;
+            double bearing = random.next() * 2.0 * 3.14159265358979323846;
+            double angle = distance / geo::EARTH_RADIUS_NM, latitude = LATITUDE * geo::DEG_TO_RAD;
+            double destination = std::asin(std::sin(latitude) * std::cos(angle) + std::cos(latitude) * std::sin(angle) * std::cos(bearing));
+            controller.latitude = destination / geo::DEG_TO_RAD;
+            controller.longitude = LONGITUDE + std::atan2(std::sin(bearing) * std::sin(angle) * std::cos(latitude),
+                std::cos(angle) - std::sin(latitude) * std::sin(destination)) / geo::DEG_TO_RAD;
+            before.update(controller);
+            after.update(controller);
+            positions.push_back(controller.latitude, controller.longitude);
+        }
+        after.setReference(self, LATITUDE, LONGITUDE, RANGE_NM);
+
+        CHECK(before.getNearbyCount() == after.getNearbyCount());
+        CHECK(before.getNearbyCount() == geo::countWithin(LATITUDE, LONGITUDE, positions, RANGE_NM));
+        CHECK(before.getNearbyCount() > 0 && before.getNearbyCount() < 5000);
+
+        // Moving everyone out and back in through updates keeps the gauge in step
+        before.setReference(self, LATITUDE, LONGITUDE, 0.0);
+        CHECK(before.getNearbyCount() == 0);
+        before.setReference(self, LATITUDE, LONGITUDE, RANGE_NM);
+        CHECK(before.getNearbyCount() == after.getNearbyCount());
+    }
+
+    void targetGrid()
+    {
+        // A target moving to another cell leaves the old one, a box over either sees it once
+        TargetGrid grid;
+        PackedCallsign moving = packCallsign("AFR123");
+        grid.update(moving, 49.1, 2.6, 100);
+        CHECK(grid.countInBox(48.9, 2.4, 49.3, 2.8) == 1);
+        grid.update(moving, 51.2, 2.6, 110);
+        CHECK(grid.size() == 1);
+        CHECK(grid.countInBox(48.9, 2.4, 49.3, 2.8) == 0);
+        CHECK(grid.countInBox(51.0, 2.4, 51.4, 2.8) == 1);
+        CHECK(grid.countWithin(51.2, 2.6, 5.0) == 1);
+
+        // Expiry drops the targets without update since maxAge and their in range count with them
+        grid.setReference(51.0, 2.5, 100.0);
+        grid.update(packCallsign("BAW45"), 51.1, 2.4, 150);
+        CHECK(grid.getInRangeCount() == 2);
+        grid.expire(175, 60);
+        CHECK(grid.size() == 1 && grid.getInRangeCount() == 1);
+        CHECK(grid.countWithin(51.2, 2.6, 5.0) == 0);
+        grid.reset();
+        CHECK(grid.size() == 0 && grid.getInRangeCount() == 0);
+
+        // The count rebuilt by setReference, which counts cells whose four corners are in range
+        // without looking at their members, matches the one kept by updates and a full scan
+        Random random;
+        TargetGrid rebuilt, updated;
+        constexpr double LATITUDE = 49.0, LONGITUDE = 2.5, RANGE_NM = 150.0;
+        updated.setReference(LATITUDE, LONGITUDE, RANGE_NM);
+        std::vector<std::pair<double, double>> positions;
+        for (int i = 0; i < 4000; ++i) {
+            char callsign[16];
+            std::snprintf(callsign, sizeof(callsign), "T%04d", i);
+            double latitude = LATITUDE + (random.next() - 0.5) * 6.0;
+            double longitude = LONGITUDE + (random.next() - 0.5) * 9.0;
+            rebuilt.update(packCallsign(callsign), latitude, longitude, 200);
+            updated.update(packCallsign(callsign), latitude, longitude, 200);
+            positions.emplace_back(latitude, longitude);
+        }
+        auto scan = [&](double latitude, double longitude, double rangeNm) {
+            uint32_t count = 0;
+            for (const auto& [targetLatitude, targetLongitude] : positions)
+                count += geo::distanceNm(latitude, longitude, targetLatitude, targetLongitude) <= rangeNm;
+            return count;
+        };
+        rebuilt.setReference(LATITUDE, LONGITUDE, RANGE_NM);
+        uint32_t inRange = scan(LATITUDE, LONGITUDE, RANGE_NM);
+        CHECK(inRange > 1000 && inRange < 4000);
+        CHECK(rebuilt.getInRangeCount() == inRange);
+        CHECK(updated.getInRangeCount() == inRange);
+        CHECK(rebuilt.countWithin(LATITUDE, LONGITUDE, RANGE_NM) == inRange);
+
+        // Moving the reference rebuilds the count, moving back restores it
+        rebuilt.setReference(50.5, 4.0, 60.0);
+        CHECK(rebuilt.getInRangeCount() == scan(50.5, 4.0, 60.0));
+        rebuilt.setReference(LATITUDE, LONGITUDE, RANGE_NM);
+        CHECK(rebuilt.getInRangeCount() == inRange);
+        rebuilt.setReference(LATITUDE, LONGITUDE, 0.0);
+        CHECK(rebuilt.getInRangeCount() == 0 && !rebuilt.hasReference());
+    }
+
+    void sectorForecast()
+    {
+        SectorForecast forecast;
+        PackedCallsign first = packCallsign("AFR1"), second = packCallsign("BAW2"), third = packCallsign("DLH3");
+
+        // Buckets are stamped with the absolute minute: 1020 sits at slot 60, so the window to 1030
+        // wraps past the end of the ring
+        forecast.update(first, 6, 20, 1020);
+        CHECK(forecast.inboundWithin(10, 1020) == 1);
+        CHECK(forecast.inboundWithin(5, 1020) == 0);
+        CHECK(forecast.outboundWithin(19, 1020) == 0 && forecast.outboundWithin(20, 1020) == 1);
+        forecast.update(first, 8, 20, 1020); // re-bucketed by its own update
+        CHECK(forecast.inboundWithin(7, 1020) == 0 && forecast.inboundWithin(8, 1020) == 1);
+
+        // Already inside, never entering and past the horizon are not entries; leaving now is an exit
+        forecast.update(second, 0, 0, 1020);
+        forecast.update(third, SectorForecast::HORIZON_MINUTES, -1, 1020);
+        CHECK(forecast.inboundWithin(SectorForecast::HORIZON_MINUTES, 1020) == 1);
+        CHECK(forecast.outboundWithin(0, 1020) == 1);
+        forecast.update(third, SectorForecast::HORIZON_MINUTES - 1, -1, 1020);
+        CHECK(forecast.inboundWithin(1000, 1020) == 2); // clamped to the horizon
+        forecast.remove(third);
+        forecast.remove(second);
+        CHECK(forecast.inboundWithin(63, 1020) == 1 && forecast.outboundWithin(63, 1020) == 1);
+
+        // 64 minutes later the slot of minute 1028 holds 1092: the stale count is dropped on reuse,
+        // and the late update of the old prediction leaves the new bucket alone
+        forecast.update(second, 10, -1, 1082);
+        CHECK(forecast.inboundWithin(10, 1082) == 1);
+        CHECK(forecast.inboundWithin(10, 1020) == 0); // the stamp no longer matches minute 1028
+        forecast.update(first, -1, -1, 1082);
+        CHECK(forecast.inboundWithin(10, 1082) == 1);
+        CHECK(forecast.outboundWithin(63, 1020) == 0);
+
+        forecast.reset();
+        CHECK(forecast.inboundWithin(63, 1082) == 0 && forecast.outboundWithin(63, 1082) == 0);
+    }
+
+    void workloadEstimator()
+    {
+        // The first call only takes the tracked count as the average, the score starts on the next
+        WorkloadEstimator estimator(10.0, 7.0);
+        estimator.setTracked(6);
+        CHECK(!estimator.update(1000));
+        CHECK(estimator.getScore() == 0.0);
+        CHECK(!estimator.update(1000)); // same second, nothing to fold
+        CHECK(!estimator.update(1001));
+        CHECK(std::fabs(estimator.getScore() - 6.0) < 1e-9);
+
+        // A short burst, a dozen more tracks for ten seconds and five handoffs at once, stays
+        // below the threshold: the averages only move by a fraction of it
+        int64_t now = 1001;
+        estimator.setTracked(18);
+        estimator.recordHandoff(5);
+        for (int second = 0; second < 10; ++second) CHECK(!estimator.update(++now));
+        CHECK(estimator.getScore() > 8.0); // the burst did register
+        estimator.setTracked(6);
+        for (int second = 0; second < 900; ++second) CHECK(!estimator.update(++now));
+        CHECK(!estimator.isOnFire() && estimator.getScore() < 6.5);
+
+        // Sustained load does, once, when the score reaches the on threshold
+        estimator.setTracked(14);
+        int changes = 0;
+        double scoreBefore = estimator.getScore();
+        for (int second = 0; second < 900; ++second) {
+            if (estimator.update(++now)) {
+                ++changes;
+                CHECK(scoreBefore < 10.0 && estimator.getScore() >= 10.0);
+            }
+            scoreBefore = estimator.getScore();
+        }
+        CHECK(changes == 1 && estimator.isOnFire());
+
+        // Between the thresholds it stays on, it clears only once the score is below 7
+        estimator.setTracked(8);
+        for (int second = 0; second < 1800; ++second) CHECK(!estimator.update(++now));
+        CHECK(estimator.isOnFire() && estimator.getScore() < 10.0);
+        estimator.setTracked(4);
+        changes = 0;
+        for (int second = 0; second < 900; ++second) {
+            if (estimator.update(++now)) {
+                ++changes;
+                CHECK(scoreBefore >= 7.0 && estimator.getScore() < 7.0);
+            }
+            scoreBefore = estimator.getScore();
+        }
+        CHECK(changes == 1 && !estimator.isOnFire());
+
+        estimator.reset();
+        CHECK(estimator.getScore() == 0.0 && !estimator.isOnFire());
+    }
+
+    void voiceStats()
+    {
+        // Half second log2 buckets, the last one open ended
+        const std::pair<uint64_t, size_t> BOUNDARIES[] = { { 0, 0 }, { 499, 0 }, { 500, 1 }, { 999, 1 }, { 1000, 2 },
+            { 1999, 2 }, { 2000, 3 }, { 3999, 3 }, { 4000, 4 }, { 7999, 4 }, { 8000, 5 }, { 15999, 5 }, { 16000, 6 },
+            { 31999, 6 }, { 32000, 7 }, { 600000, 7 }, { UINT64_MAX, 7 } };
+        for (const auto& [durationMs, bucket] : BOUNDARIES) CHECK(VoiceStats::bucketFor(durationMs) == bucket);
+
+        // An end without its start, from a plugin loaded mid transmission, is ignored, and so is a
+        // second end of the same transmission
+        VoiceStats voice;
+        voice.transmitEnded();
+        CHECK(voice.getTransmissions() == 0);
+        voice.transmitStarted();
+        voice.receiveStarted();
+        voice.transmitEnded();
+        voice.transmitEnded();
+        VoiceStats::Summary summary = voice.getSummary();
+        CHECK(summary.transmissions == 1 && summary.receptions == 1);
+        CHECK(summary.airtimeMs < 500 && summary.lengths[0] == 1);
+
+        voice.reset();
+        summary = voice.getSummary();
+        CHECK(summary.transmissions == 0 && summary.airtimeMs == 0 && summary.receptions == 0 && summary.lengths[0] == 0);
+    }
+
+    void commsStats()
+    {
+        // EuroScope repeats a message once per frequency it went out on: same sender, text and
+        // second. A new second, text or sender in between counts again; private chat is never merged.
+        CommsStats comms;
+        comms.recordFrequencyMessage("AFR12", "descend FL120", 100);
+        comms.recordFrequencyMessage("AFR12", "descend FL120", 100);
+        comms.recordFrequencyMessage("AFR12", "descend FL120", 100);
+        CHECK(comms.getTotalMessages() == 1);
+        comms.recordFrequencyMessage("AFR12", "descend FL120", 101);
+        comms.recordFrequencyMessage("AFR12", "descending FL120", 101);
+        comms.recordFrequencyMessage("BAW34", "hello", 101);
+        comms.recordFrequencyMessage("AFR12", "descending FL120", 101);
+        CHECK(comms.getTotalMessages() == 5);
+        comms.recordPrivateMessage("AFR12", "ok", 101);
+        comms.recordPrivateMessage("AFR12", "ok", 101);
+        CHECK(comms.getTotalMessages() == 7);
+        CHECK(comms.frequencyPerMinute(101) == 5.0 && comms.privatePerMinute(101) == 2.0);
+        CommsStats::Sender top = comms.topSenders()[0];
+        CHECK(top.callsign == packCallsign("AFR12") && top.count == 6 && top.error == 0);
+        comms.reset();
+        CHECK(comms.getTotalMessages() == 0 && comms.topSenders()[0].count == 0);
+
+        // Eight senders fill the slots with 10 down to 3 messages. A ninth takes the slot of the
+        // least counted and inherits its count as the error bound.
+        auto sender = [](int index) {
+            char callsign[16];
+            std::snprintf(callsign, sizeof(callsign), "S%d", index);
+            return std::string(callsign);
+        };
+        int64_t now = 200;
+        for (int index = 0; index < 8; ++index)
+            for (int message = 0; message < 10 - index; ++message) comms.recordPrivateMessage(sender(index).c_str(), "m", ++now);
+        comms.recordPrivateMessage("NEW1", "m", ++now);
+        auto find = [&](const std::string& callsign) {
+            for (const CommsStats::Sender& slot : comms.topSenders())
+                if (slot.callsign == packCallsign(callsign)) return slot;
+            return CommsStats::Sender{};
+        };
+        CHECK(find("NEW1").count == 4 && find("NEW1").error == 3);
+        CHECK(find(sender(7)).count == 0);
+        CHECK(comms.topSenders()[0].callsign == packCallsign(sender(0)) && comms.topSenders()[0].count == 10);
+        // The evicted sender returns and takes the first least counted slot, S6 with 4
+        comms.recordPrivateMessage(sender(7).c_str(), "m", ++now);
+        CHECK(find(sender(7)).count == 5 && find(sender(7)).error == 4);
+        CHECK(find(sender(6)).count == 0 && find("NEW1").count == 4);
+
+        // On a skewed stream every slot brackets the true count and the heavy senders stay
+        comms.reset();
+        Random random;
+        std::vector<uint32_t> truth(40);
+        for (int message = 0; message < 4000; ++message) {
+            int index = random.next() < 0.5 ? static_cast<int>(random.next() * 3) : static_cast<int>(random.next() * 40);
+            ++truth[index];
+            comms.recordPrivateMessage(sender(index).c_str(), "m", ++now);
+        }
+        for (const CommsStats::Sender& slot : comms.topSenders()) {
+            if (slot.count == 0) continue;
+            uint32_t actual = 0;
+            for (int index = 0; index < 40; ++index)
+                if (packCallsign(sender(index)) == slot.callsign) actual = truth[index];
+            CHECK(slot.count - slot.error <= actual && actual <= slot.count);
+        }
+        for (int index = 0; index < 3; ++index) CHECK(find(sender(index)).count >= truth[index]);
+    }
+
+    void flightRecorderRoundTrip()
+    {
+        static FlightRecorder recorder; // the event ring is too large for the stack
+        using EventType = FlightRecorder::EventType;
+        TemporaryFile file("rpc-core-tests.blackbox");
+
+        // Before the ring is full the snapshot is every event in order, the dump reads back the same
+        recorder.record(EventType::LEADER_CHANGE, 0, 1);
+        recorder.record(EventType::STATE_CHANGE, 0, 1);
+        recorder.countCallback(FlightRecorder::Callback::TIMER);
+        recorder.countCallback(FlightRecorder::Callback::TIMER);
+        recorder.flushCallbacks();
+        std::vector<FlightRecorder::Event> snapshot = recorder.snapshot();
+        CHECK(snapshot.size() == 3);
+        CHECK(recorder.dump(file.path()));
+        FlightRecorder::FileHeader header{};
+        std::vector<FlightRecorder::Event> loaded;
+        CHECK(FlightRecorder::load(file.path(), header, loaded) == FlightRecorder::LoadResult::OK);
+        CHECK(header.count == 3 && loaded.size() == 3);
+        CHECK(loaded.size() == 3 && std::memcmp(loaded.data(), snapshot.data(), 3 * sizeof(FlightRecorder::Event)) == 0);
+        CHECK(loaded.size() == 3 && FlightRecorder::describe(loaded[0]) == "became leader");
+        CHECK(loaded.size() == 3 && FlightRecorder::describe(loaded[1]) == "IDLE -> CONTROLLING");
+        CHECK(loaded.size() == 3 && FlightRecorder::describe(loaded[2]) == "OnTimer x2");
+        CHECK(recorder.snapshot().back().type == static_cast<uint16_t>(EventType::DUMP)); // the dump itself, after the file
+
+        // Past the 16384 event wrap the snapshot holds the last CAPACITY events, oldest first
+        for (uint32_t value = 0; value < FlightRecorder::CAPACITY + 1000; ++value)
+            recorder.record(EventType::ON_FIRE_CHANGE, 0, value);
+        snapshot = recorder.snapshot();
+        CHECK(snapshot.size() == FlightRecorder::CAPACITY);
+        bool ordered = true;
+        for (size_t i = 0; i < snapshot.size(); ++i) {
+            ordered = ordered && snapshot[i].value == 1000 + i && snapshot[i].type == static_cast<uint16_t>(EventType::ON_FIRE_CHANGE);
+            if (i > 0) ordered = ordered && snapshot[i].timestamp >= snapshot[i - 1].timestamp;
+        }
+        CHECK(ordered);
+        CHECK(recorder.dump(file.path()));
+        CHECK(FlightRecorder::load(file.path(), header, loaded) == FlightRecorder::LoadResult::OK);
+        CHECK(header.count == FlightRecorder::CAPACITY && loaded.size() == snapshot.size());
+        CHECK(loaded.size() == snapshot.size() && std::memcmp(loaded.data(), snapshot.data(), snapshot.size() * sizeof(FlightRecorder::Event)) == 0);
+
+        // A file cut short keeps the events before the cut, anything else is refused
+        std::filesystem::resize_file(file.path(), sizeof(header) + 10 * sizeof(FlightRecorder::Event) + 3);
+        CHECK(FlightRecorder::load(file.path(), header, loaded) == FlightRecorder::LoadResult::TRUNCATED && loaded.size() == 10);
+        std::filesystem::resize_file(file.path(), 4);
+        CHECK(FlightRecorder::load(file.path(), header, loaded) == FlightRecorder::LoadResult::NOT_A_DUMP);
+        std::filesystem::remove(file.path());
+        CHECK(FlightRecorder::load(file.path(), header, loaded) == FlightRecorder::LoadResult::UNREADABLE);
+    }
+
+    void sessionRoundTrip()
+    {
+        using namespace rpc::session;
+        TemporaryFile file("rpc-core-tests.session");
+        static SessionRecorder recorder; // the capture ring is too large for the stack
+        constexpr int64_t START_MS = 1760000000000;
+        constexpr int TARGETS = 300, SWEEPS = 48; // four minutes of the three hour session below
+        CHECK(recorder.start(file.path(), START_MS));
+
+        // Paced on what the writer thread took, so nothing is dropped for lack of room
+        uint64_t enqueued = 0;
+        auto push = [&](const Event& event) {
+            while (enqueued - recorder.getRecorded() >= SessionRecorder::QUEUE_CAPACITY)
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            CHECK(recorder.enqueue(event));
+            ++enqueued;
+        };
+        Event connection;
+        connection.timeMs = START_MS;
+        connection.code = 1;
+        push(connection);
+
+        // Every target reports every 5 s, moving and with the sector forecast fed on each update
+        std::vector<Event> positions, forecasts;
+        for (int sweep = 0; sweep < SWEEPS; ++sweep) {
+            int64_t second = sweep * 5;
+            for (int target = 0; target < TARGETS; ++target) {
+                Event position;
+                position.timeMs = START_MS + second * 1000 + target * 16;
+                position.type = RecordType::RADAR_POSITION;
+                std::snprintf(position.callsign, sizeof(position.callsign), "AFR%d", 1000 + target);
+                position.latitude = static_cast<int32_t>(std::lround((45.0 + target * 0.01 + (sweep + 1) * 0.01) * COORDINATE_SCALE));
+                position.longitude = static_cast<int32_t>(std::lround((2.0 + target * 0.01 + (sweep + 1) * 0.012) * COORDINATE_SCALE));
+                position.altitude = 35000 + (second % 60 == 0 ? 100 : 0);
+                position.groundSpeed = 450;
+                push(position);
+                positions.push_back(position);
+
+                Event forecast = position;
+                forecast.type = RecordType::FLIGHT_PLAN_DATA;
+                forecast.latitude = forecast.longitude = forecast.altitude = forecast.groundSpeed = 0;
+                forecast.entryMinutes = target % 10 == 0 ? std::max<int>(0, 30 - static_cast<int>(second / 60)) : -1;
+                push(forecast);
+                forecasts.push_back(forecast);
+            }
+        }
+        Event assigned;
+        assigned.timeMs = START_MS + SWEEPS * 5000;
+        assigned.type = RecordType::CONTROLLER_ASSIGNED;
+        std::snprintf(assigned.callsign, sizeof(assigned.callsign), "AFR1000");
+        assigned.code = 4;
+        assigned.flags = TRACKING_IS_ME | IS_INSTRUCTION;
+        push(assigned);
+        recorder.stop();
+        CHECK(recorder.getDropped() == 0 && recorder.getRecorded() == enqueued);
+        CHECK(std::filesystem::file_size(file.path()) == recorder.getBytesWritten());
+
+        // Read back: every position exactly, the forecasts the encoder kept, the other records
+        std::vector<uint8_t> bytes(std::filesystem::file_size(file.path()));
+        FILE* input = std::fopen(file.path().c_str(), "rb");
+        CHECK(input && std::fread(bytes.data(), 1, bytes.size(), input) == bytes.size());
+        if (input) std::fclose(input);
+        SessionReader reader(bytes.data(), bytes.size());
+        CHECK(reader.isValid() && reader.getStartMs() == START_MS);
+        size_t positionIndex = 0, forecastIndex = 0, forecastsRead = 0, others = 0;
+        bool positionsMatch = true, forecastsMatch = true;
+        Event event;
+        while (reader.next(event)) {
+            if (event.type == RecordType::RADAR_POSITION) {
+                const Event* expected = positionIndex < positions.size() ? &positions[positionIndex++] : nullptr;
+                positionsMatch = positionsMatch && expected && event.timeMs == expected->timeMs
+                    && std::strcmp(event.callsign, expected->callsign) == 0 && event.latitude == expected->latitude
+                    && event.longitude == expected->longitude && event.altitude == expected->altitude && event.groundSpeed == expected->groundSpeed;
+            }
+            else if (event.type == RecordType::FLIGHT_PLAN_DATA) {
+                // Repeats within a minute are dropped by the encoder, the ones kept carry their values
+                while (forecastIndex < forecasts.size() && forecasts[forecastIndex].timeMs < event.timeMs) ++forecastIndex;
+                const Event* expected = forecastIndex < forecasts.size() ? &forecasts[forecastIndex] : nullptr;
+                forecastsMatch = forecastsMatch && expected && std::strcmp(event.callsign, expected->callsign) == 0
+                    && event.entryMinutes == expected->entryMinutes && event.exitMinutes == expected->exitMinutes;
+                ++forecastsRead;
+            }
+            else {
+                if (event.type == RecordType::CONNECTION_TYPE) CHECK(event.code == 1 && event.timeMs == START_MS);
+                if (event.type == RecordType::CONTROLLER_ASSIGNED)
+                    CHECK(event.code == 4 && event.flags == assigned.flags && std::strcmp(event.callsign, "AFR1000") == 0);
+                ++others;
+            }
+        }
+        CHECK(!reader.isCorrupt() && reader.getOffset() == bytes.size());
+        CHECK(positionsMatch && positionIndex == positions.size());
+        // One forecast per target and clock minute, and one more whenever the entry moves mid minute
+        size_t forecastsKept = 0;
+        for (int target = 0; target < TARGETS; ++target) {
+            int64_t lastMinute = -1;
+            int32_t lastEntry = -2;
+            for (size_t i = target; i < forecasts.size(); i += TARGETS) {
+                int64_t minute = forecasts[i].timeMs / 60000;
+                if (minute == lastMinute && forecasts[i].entryMinutes == lastEntry) continue;
+                lastMinute = minute;
+                lastEntry = forecasts[i].entryMinutes;
+                ++forecastsKept;
+            }
+        }
+        CHECK(forecastsMatch && forecastsRead == forecastsKept);
+        CHECK(others == 2 && reader.getCallsignCount() == TARGETS);
+
+        // The recording commit measured 6.6 MB for three hours of this traffic: scaled from the
+        // four minutes, within 10 %
+        double threeHours = static_cast<double>(bytes.size()) * (3 * 3600) / (SWEEPS * 5);
+        CHECK(threeHours > 6.6e6 * 0.9 && threeHours < 6.6e6 * 1.1);
+    }
+
+    void vatsimFeed()
+    {
+        VatsimFeed feed;
+        const std::string pilot = R"({"cid":1,"callsign":"AFR1234","latitude":49.0123,"longitude":-2.5,"altitude":35012.4,"groundspeed":451)";
+        const std::string controller = R"({"callsign":"LFPG_N_APP","frequency":"118.150","facility":5,"rating":7,"visual_range":150})";
+
+        // Escaped quotes and backslashes at every offset of a 16 byte block, in a string the
+        // scanner skips alone and in one inside a skipped object
+        for (size_t padding = 0; padding < 32; ++padding) {
+            std::string remarks = std::string(padding, 'x') + R"(\"quoted\" \\ path\\)";
+            std::string json = R"({"general":{"version":3,"update_timestamp":"2024-05-04T12:34:56.1234567Z"},"pilots":[)" + pilot
+                + R"(,"remarks":")" + remarks + R"(","flight_plan":{"route":")" + remarks + R"(","altitude":"FL350"}}],"controllers":[)"
+                + controller + "]}";
+            CHECK(feed.parse(json));
+            CHECK(feed.getTimestampMs() == 1714826096123);
+            CHECK(feed.getPilots().size() == 1 && feed.getControllers().size() == 1);
+            if (feed.getPilots().size() != 1 || feed.getControllers().size() != 1) continue;
+            const VatsimFeed::Pilot& parsed = feed.getPilots()[0];
+            CHECK(std::strcmp(parsed.callsign, "AFR1234") == 0);
+            CHECK(parsed.latitude == 49.0123 && parsed.longitude == -2.5);
+            CHECK(parsed.altitude == 35012 && parsed.groundSpeed == 451);
+            const VatsimFeed::Controller& station = feed.getControllers()[0];
+            CHECK(std::strcmp(station.callsign, "LFPG_N_APP") == 0);
+            CHECK(station.frequencyKhz == 118150 && station.facility == 5 && station.rating == 7 && station.visualRange == 150);
+        }
+
+        // null in place of the arrays, unknown sections skipped, callsigns cut to fit
+        CHECK(feed.parse(R"({"general":{},"pilots":null,"controllers":null,"servers":[{"name":"[x]"}],"atis":[]})"));
+        CHECK(feed.getPilots().empty() && feed.getControllers().empty() && feed.getTimestampMs() == 0);
+        CHECK(feed.parse(R"( {"pilots":[{"callsign":"ABCDEFGHIJKLMNOPQRS"}, {}]} )"));
+        CHECK(feed.getPilots().size() == 2 && std::strcmp(feed.getPilots()[0].callsign, "ABCDEFGHIJKLMNO") == 0);
+
+        // Malformed input fails with an error and leaves nothing behind, the next parse works again
+        const char* const MALFORMED[] = {
+            "",
+            R"({"pilots":[)",
+            R"({"pilots":[{"callsign":"AFR1"} {"callsign":"AFR2"}]})",
+            R"({"pilots":[{"callsign":"AFR1","latitude":north}]})",
+            R"({"general":{"update_timestamp":"2024-05-04T12:34:56Z"},"atis":[{"text_atis":["unterminated \"]}]})",
+            R"({"atis":[{"text_atis":"ends on an escape \)",
+            R"({"pilots":[]}})",
+            R"({"pilots":[]} trailing)",
+        };
+        for (const char* json : MALFORMED) {
+            CHECK(feed.parse(R"({"pilots":[{"callsign":"AFR1"}]})") && feed.getPilots().size() == 1);
+            CHECK(!feed.parse(json));
+            CHECK(!feed.getError().empty() && feed.getPilots().empty() && feed.getControllers().empty());
+        }
+        CHECK(feed.parse(R"({"pilots":[]})") && feed.getError().empty());
+
+        // Timestamps: fraction cut to milliseconds, leap day, before the epoch, not in the form
+        CHECK(VatsimFeed::parseTimestamp("1970-01-01T00:00:00Z") == 0);
+        CHECK(VatsimFeed::parseTimestamp("2024-05-04T12:34:56.1234567Z") == 1714826096123);
+        CHECK(VatsimFeed::parseTimestamp("2024-05-04T12:34:56.5Z") == 1714826096500);
+        CHECK(VatsimFeed::parseTimestamp("2000-02-29T23:59:59Z") == 951868799000);
+        CHECK(VatsimFeed::parseTimestamp("1969-12-31T23:59:59Z") == -1000);
+        CHECK(VatsimFeed::parseTimestamp("2024-13-04T12:34:56Z") == -1);
+        CHECK(VatsimFeed::parseTimestamp("2024-05-04") == -1);
+        CHECK(VatsimFeed::parseTimestamp("2024-05-04T12:3x:56Z") == -1);
+    }
+
+    void seqlockDeadWriter()
+    {
+        struct Snapshot {
+            uint32_t tracked;
+            char callsign[16];
+        };
+        Seqlock<Snapshot> lock;
+        lock.store({ 3, "LFPG_TWR" });
+
+        // A writer killed between its two sequence stores, as another process sharing the lock can
+        // be. The sequence is the first member of a standard layout class, so it can be reached.
+        static_assert(std::is_standard_layout_v<Seqlock<Snapshot>>);
+        auto& sequence = *reinterpret_cast<std::atomic<uint64_t>*>(&lock);
+        sequence.fetch_add(1);
+
+        Snapshot snapshot{};
+        CHECK(!lock.tryLoad(snapshot));
+        CHECK(!lock.tryLoad(snapshot, 8)); // gives up instead of spinning forever
+
+        // The next owner of the slot stores over it and readers see whole values again
+        lock.store({ 5, "LFPG_GND" });
+        CHECK(lock.version() % 2 == 0);
+        CHECK(lock.tryLoad(snapshot, 1) && snapshot.tracked == 5 && std::strcmp(snapshot.callsign, "LFPG_GND") == 0);
+        lock.store({ 6, "LFPG_DEL" });
+        CHECK(lock.tryLoad(snapshot) && snapshot.tracked == 6);
+    }
+
+    void sessionTracks()
+    {
+        using Join = SessionTracks::Join;
+        using Status = SessionTracks::Status;
+        SessionTracks tracks;
+        PackedCallsign first = packCallsign("AFR12");
+        PackedCallsign second = packCallsign("BAW34");
+        CHECK(tracks.start(first) == Join::FIRST);
+        CHECK(tracks.start(first) == Join::NONE);
+        CHECK(tracks.start(second) == Join::FIRST);
+        tracks.release(first);
+        CHECK(tracks.find(first)->status == Status::RELEASED);
+        CHECK(tracks.start(first) == Join::NONE); // still listed, mine again
+        CHECK(tracks.find(first)->status == Status::TRACKED);
+
+        // Flight plan gone: leaves the list, comes back on the next track
+        CHECK(tracks.disconnect(second));
+        CHECK(!tracks.disconnect(second));
+        CHECK(tracks.start(second) == Join::RELISTED);
+        CHECK(tracks.size() == 2);
+
+        // Network disconnect: everything stays listed, nothing shows as mine
+        tracks.releaseAll();
+        CHECK(tracks.find(first)->status == Status::RELEASED && tracks.find(second)->status == Status::RELEASED);
+        CHECK(tracks.find(first)->listed && tracks.find(second)->listed);
+        CHECK(tracks.start(first) == Join::NONE);
+        CHECK(std::strcmp(SessionTracks::statusText(tracks.find(first)->status), "Mine") == 0);
+    }
+
+    void slidingWindowLimit()
+    {
+        // Discord's presence budget: never more than 5 updates in any 20 seconds
+        constexpr uint64_t SECOND = 1000000000;
+        SlidingWindowLimit<5> limit(20 * SECOND);
+        uint64_t start = 1000 * SECOND;
+        for (int i = 0; i < 5; ++i) CHECK(limit.tryTake(start + i * SECOND));
+        CHECK(!limit.tryTake(start + 5 * SECOND));
+        CHECK(!limit.tryTake(start + 20 * SECOND - 1));
+        CHECK(limit.tryTake(start + 20 * SECOND)); // the first left the window
+        CHECK(!limit.tryTake(start + 20 * SECOND + SECOND / 2));
+        CHECK(limit.tryTake(start + 21 * SECOND));
+
+        // An update every half second for two minutes, checked over every 20 second window
+        SlidingWindowLimit<5> steady(20 * SECOND);
+        std::vector<uint64_t> sent;
+        for (uint64_t now = start; now < start + 120 * SECOND; now += SECOND / 2)
+            if (steady.tryTake(now)) sent.push_back(now);
+        CHECK(sent.size() == 30);
+        for (size_t i = 5; i < sent.size(); ++i) CHECK(sent[i] - sent[i - 5] >= 20 * SECOND);
+    }
+
+    struct Test {
+        const char* name;
+        void (*run)();
+    };
+
+    constexpr Test TESTS[] = {
+        { "histogram-buckets", histogramBuckets },
+        { "histogram-percentiles", histogramPercentiles },
+        { "histogram-merge", histogramMerge },
+        { "control-time-round-trip", controlTimeRoundTrip },
+        { "duration-text", durationText },
+        { "presence-cadence", presenceCadence },
+        { "badge-rule-errors", badgeRuleErrors },
+        { "badge-unlocks", badgeUnlocks },
+        { "handoff-tracking", handoffTracking },
+        { "message-queue", messageQueue },
+        { "metar-parsing", metarParsing },
+        { "metar-cache", metarCache },
+        { "movement-state-machine", movementStateMachine },
+        { "movement-rates", movementRates },
+        { "runway-cache", runwayCache },
+        { "seqlock-dead-writer", seqlockDeadWriter },
+        { "session-tracks", sessionTracks },
+        { "sliding-window-limit", slidingWindowLimit },
+        { "geo-batch-error", geoBatchError },
+        { "controller-nearby", controllerNearby },
+        { "target-grid", targetGrid },
+        { "sector-forecast", sectorForecast },
+        { "workload-estimator", workloadEstimator },
+        { "voice-stats", voiceStats },
+        { "comms-stats", commsStats },
+        { "flight-recorder-round-trip", flightRecorderRoundTrip },
+        { "session-round-trip", sessionRoundTrip },
+        { "vatsim-feed", vatsimFeed },
+    };
+}
+
+int main(int argc, char** argv)
+{
+    const char* filter = argc > 1 ? argv[1] : "";
+    int run = 0;
+    for (const Test& test : TESTS) {
+        if (!std::strstr(test.name, filter)) continue;
+        int before = failures;
+        test.run();
+        ++run;
+        std::printf("%-28s %s\n", test.name, failures == before ? "ok" : "FAILED");
+    }
+    std::printf("%d tests, %d failed checks\n", run, failures);
+    return failures == 0 && run > 0 ? 0 : 1;
+}
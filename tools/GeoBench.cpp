@@ -0,0 +1,76 @@
+// Times the batched great circle kernel on 10,000 points per call, through the AVX2 path when the
+// CPU has it and through the scalar one, for distancesNm and countWithin. Points are spread over
+// the globe, so the wide angle form past 152 degrees of arc is part of the figure.
+//
+//     rpc-geo-bench [points]
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "Geo.h"
+#include "GeoBatch.h"
+
+using namespace rpc;
+
+namespace {
+    constexpr int CALLS = 200;
+    constexpr int ROUNDS = 9; // the fastest counts, slower ones met another process on the core
+
+    // Best time per call over the rounds, in microseconds
+    template <typename Call>
+    double bestMicroseconds(Call&& call)
+    {
+        double best = 0.0;
+        for (int round = 0; round < ROUNDS; ++round) {
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < CALLS; ++i) call(i);
+            double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / CALLS;
+            if (round == 0 || us < best) best = us;
+        }
+        return best;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int points = argc > 1 ? std::atoi(argv[1]) : 10000;
+    if (points < 1) {
+        std::fprintf(stderr, "usage: %s [points]\n", argv[0]);
+        return 2;
+    }
+
+    uint64_t state = 12345;
+    auto random = [&state] {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        return static_cast<double>(state >> 11) * (1.0 / 9007199254740992.0);
+    };
+    geo::PointBatch batch;
+    batch.reserve(points);
+    for (int i = 0; i < points; ++i) batch.push_back(std::asin(random() * 2.0 - 1.0) / geo::DEG_TO_RAD, random() * 360.0 - 180.0);
+    std::vector<float> distances(points);
+
+    // A different reference per call, as the registry and the target grid see
+    double references[CALLS][2];
+    for (auto& reference : references) {
+        reference[0] = std::asin(random() * 2.0 - 1.0) / geo::DEG_TO_RAD;
+        reference[1] = random() * 360.0 - 180.0;
+    }
+
+    std::printf("%d points per call, best of %d rounds of %d calls\n", points, ROUNDS, CALLS);
+    size_t sink = 0;
+    for (bool avx2 : { true, false }) {
+        if (avx2 && !geo::hasAvx2()) {
+            std::printf("AVX2    not supported by this CPU\n");
+            continue;
+        }
+        geo::setAvx2Enabled(avx2);
+        double distancesUs = bestMicroseconds([&](int i) { geo::distancesNm(references[i][0], references[i][1], batch, distances.data()); });
+        double countUs = bestMicroseconds([&](int i) { sink += geo::countWithin(references[i][0], references[i][1], batch, 250.0); });
+        std::printf("%-7s distancesNm %8.1f us (%.2f ns/point), countWithin %8.1f us (%.2f ns/point)\n", avx2 ? "AVX2" : "scalar",
+            distancesUs, distancesUs * 1000.0 / points, countUs, countUs * 1000.0 / points);
+    }
+    geo::setAvx2Enabled(true);
+    return sink == static_cast<size_t>(-1) ? 1 : 0; // keeps the counts alive
+}
@@ -0,0 +1,100 @@
+// Pushes a handoff storm through HandoffTracker::update the way OnFlightPlanControllerAssignedDataUpdate
+// feeds it: every flight plan goes through an inbound offer and accept, an outbound offer taken by
+// the next sector, and an offer withdrawn, with the repeated updates EuroScope sends in between.
+// Reports the cost per event and checks the counters against the cycles pushed.
+//
+//     rpc-handoff-bench [flight plans]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <vector>
+#include "Callsign.h"
+#include "HandoffTracker.h"
+
+using namespace rpc;
+
+namespace {
+    constexpr int ROUNDS = 9; // the fastest counts, slower ones met another process on the core
+
+    // One update as the SDK reports it: tracking controller, handoff pending and to whom
+    struct Event {
+        PackedCallsign flightPlan;
+        bool trackingIsMe;
+        bool handoffPending;
+        bool handoffTargetIsMe;
+    };
+
+    // Interleaves the cycles of all flight plans, a step of each at a time, so the table holds
+    // every flight plan in some state as it does in a busy sector
+    std::vector<Event> buildStorm(const std::vector<PackedCallsign>& flightPlans)
+    {
+        static const Event CYCLE[] = {
+            { 0, false, true, true },   // offered to me
+            { 0, false, true, true },   // same data again
+            { 0, true, false, false },  // accepted: inbound
+            { 0, true, false, false },
+            { 0, true, true, false },   // offered to the next sector
+            { 0, true, true, false },
+            { 0, false, false, false }, // taken: outbound
+            { 0, false, true, true },   // offered to me again
+            { 0, false, false, false }, // withdrawn: no handoff
+        };
+        std::vector<Event> events;
+        events.reserve(flightPlans.size() * std::size(CYCLE));
+        for (const Event& step : CYCLE) {
+            for (PackedCallsign flightPlan : flightPlans) {
+                Event event = step;
+                event.flightPlan = flightPlan;
+                events.push_back(event);
+            }
+        }
+        return events;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int count = argc > 1 ? std::atoi(argv[1]) : 2000;
+    if (count < 1) {
+        std::fprintf(stderr, "usage: %s [flight plans]\n", argv[0]);
+        return 2;
+    }
+
+    std::vector<PackedCallsign> flightPlans(count);
+    for (int i = 0; i < count; ++i) {
+        char callsign[16];
+        std::snprintf(callsign, sizeof(callsign), "%s%d", i % 3 ? "DLH" : "BAW", 100 + i * 7);
+        flightPlans[i] = packCallsign(callsign);
+    }
+    std::vector<Event> events = buildStorm(flightPlans);
+
+    HandoffTracker tracker;
+    double best = 0.0;
+    uint32_t completed = 0;
+    bool countersMatch = true;
+    for (int round = 0; round < ROUNDS; ++round) {
+        tracker.reset();
+        completed = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (const Event& event : events)
+            completed += tracker.update(event.flightPlan, event.trackingIsMe, event.handoffPending, event.handoffTargetIsMe);
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / events.size();
+        if (round == 0 || ns < best) best = ns;
+
+        // One inbound and one outbound per flight plan, two offers to me, nothing left pending
+        uint32_t expected = static_cast<uint32_t>(count);
+        HandoffTracker::Counters counters = tracker.getCounters();
+        countersMatch = countersMatch && counters.inbound == expected && counters.outbound == expected
+            && counters.inboundOffered == 2 * expected && counters.outboundInitiated == expected
+            && counters.inboundPending == 0 && counters.outboundPending == 0 && completed == 2 * expected;
+    }
+
+    HandoffTracker::Counters counters = tracker.getCounters();
+    std::printf("%d flight plans, %zu events per round, best of %d rounds\n", count, events.size(), ROUNDS);
+    std::printf("%.1f ns per event\n", best);
+    std::printf("in %u, out %u, offered to me %u, offered away %u, pending %u/%u, completed %u: %s\n", counters.inbound,
+        counters.outbound, counters.inboundOffered, counters.outboundInitiated, counters.inboundPending,
+        counters.outboundPending, completed, countersMatch ? "ok" : "MISMATCH");
+    return countersMatch ? 0 : 1;
+}
@@ -0,0 +1,109 @@
+// Times the METAR path of OnNewMetarReceived and of presence rendering on a few thousand generated
+// reports: parseMetar alone, MetarCache::update (parse and seqlocked store) and MetarCache::find
+// for stations held and missing. Reports mix ICAO and US style groups so every parser branch runs.
+//
+//     rpc-metar-bench [reports] [stations]
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "MetarCache.h"
+
+using namespace rpc;
+
+namespace {
+    constexpr int ROUNDS = 9; // the fastest counts, slower ones met another process on the core
+
+    // Best time per item over the rounds, in nanoseconds
+    template <typename Pass>
+    double bestNanoseconds(size_t items, Pass&& pass)
+    {
+        double best = 0.0;
+        for (int round = 0; round < ROUNDS; ++round) {
+            auto start = std::chrono::steady_clock::now();
+            pass();
+            double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / items;
+            if (round == 0 || ns < best) best = ns;
+        }
+        return best;
+    }
+
+    std::string stationName(int index, char first)
+    {
+        char name[5] = { first, static_cast<char>('A' + index / 676 % 26), static_cast<char>('A' + index / 26 % 26),
+            static_cast<char>('A' + index % 26), '\0' };
+        return name;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int reportCount = argc > 1 ? std::atoi(argv[1]) : 4000;
+    int stationCount = argc > 2 ? std::atoi(argv[2]) : 800;
+    if (reportCount < 1 || stationCount < 1 || stationCount > static_cast<int>(MetarCache::CAPACITY)) {
+        std::fprintf(stderr, "usage: %s [reports] [stations, at most %zu]\n", argv[0], MetarCache::CAPACITY);
+        return 2;
+    }
+
+    uint64_t state = 12345;
+    auto random = [&state](int range) {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        return static_cast<int>((state >> 33) % static_cast<uint64_t>(range));
+    };
+
+    // Several reports per station, as the half hourly updates of a long session bring them
+    std::vector<std::string> stations(stationCount), reports(reportCount);
+    for (int i = 0; i < stationCount; ++i) stations[i] = stationName(i, "EKLN"[i % 4]);
+    char report[160];
+    for (int i = 0; i < reportCount; ++i) {
+        const std::string& station = stations[i % stationCount];
+        int temperature = random(40) - 10;
+        if (station[0] == 'K') {
+            std::snprintf(report, sizeof(report), "METAR %s %02d%02d51Z %03d%02dKT %d %d/4SM BR BKN%03d OVC%03d %s%02d/%s%02d A%04d RMK AO2",
+                station.c_str(), 1 + random(28), random(24), random(36) * 10, random(30), 1 + random(2), 1 + random(3),
+                random(40), 40 + random(200), temperature < 0 ? "M" : "", std::abs(temperature), temperature < 2 ? "M" : "",
+                std::abs(temperature - 2), 2950 + random(100));
+        }
+        else {
+            std::snprintf(report, sizeof(report), "%s %02d%02d20Z %03d%02dG%02dKT %04d FEW%03d SCT%03d %s%02d/%02d Q%04d NOSIG=",
+                station.c_str(), 1 + random(28), random(24), random(36) * 10, random(25), 25 + random(20), 500 + random(9500),
+                random(50), 20 + random(100), temperature < 0 ? "M" : "", std::abs(temperature), random(10), 990 + random(45));
+        }
+        reports[i] = report;
+    }
+
+    // Probes for every station held and as many that never reported
+    std::vector<std::string> missing(stationCount);
+    for (int i = 0; i < stationCount; ++i) missing[i] = stationName(i, 'Z');
+
+    Metar metar;
+    size_t parsed = 0, updated = 0, found = 0, notFound = 0;
+    double parseNs = bestNanoseconds(reports.size(), [&] {
+        parsed = 0;
+        for (const std::string& text : reports) parsed += parseMetar(text, metar);
+    });
+    static MetarCache cache; // a thousand seqlocked slots, too large for the stack
+    double updateNs = bestNanoseconds(reports.size(), [&] {
+        updated = 0;
+        int64_t now = 1700000000;
+        for (int i = 0; i < reportCount; ++i) updated += cache.update(stations[i % stationCount], reports[i], now + i);
+    });
+    double findNs = bestNanoseconds(stations.size(), [&] {
+        found = 0;
+        for (const std::string& station : stations) found += cache.find(station).has_value();
+    });
+    double missNs = bestNanoseconds(missing.size(), [&] {
+        notFound = 0;
+        for (const std::string& station : missing) notFound += !cache.find(station).has_value();
+    });
+
+    size_t all = reports.size(), held = stations.size();
+    std::printf("%d reports over %d stations, best of %d rounds\n", reportCount, stationCount, ROUNDS);
+    std::printf("parseMetar      %7.1f ns per report, %zu/%zu parsed\n", parseNs, parsed, all);
+    std::printf("update          %7.1f ns per report, %zu/%zu stored, %zu stations\n", updateNs, updated, all, cache.size());
+    std::printf("find held       %7.1f ns per lookup, %zu/%zu found\n", findNs, found, held);
+    std::printf("find missing    %7.1f ns per lookup, %zu/%zu absent\n", missNs, notFound, held);
+    return parsed == all && updated == all && found == held && notFound == held ? 0 : 1;
+}
@@ -0,0 +1,58 @@
+// Times the RunwayCache of a large sector file: the rebuild OnAirportRunwayActivityChanged runs,
+// clear() and one add per active runway end, and the find presence rendering does per airport.
+//
+//     rpc-runway-bench [airports]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "RunwayCache.h"
+
+using namespace rpc;
+
+namespace {
+    constexpr int REBUILDS = 50;
+    constexpr int LOOKUPS = 1000000;
+    constexpr int ROUNDS = 9; // the fastest counts, slower ones met another process on the core
+}
+
+int main(int argc, char** argv)
+{
+    int airports = argc > 1 ? std::atoi(argv[1]) : 1250;
+    if (airports < 1 || airports > 10000) {
+        std::fprintf(stderr, "usage: %s [airports, at most 10000]\n", argv[0]);
+        return 2;
+    }
+
+    // Four runway ends per airport, listed end by end as the sector file walk returns them
+    static const char* const ENDS[] = { "09L", "27R", "09R", "27L" };
+    struct Name {
+        char text[8];
+    };
+    std::vector<Name> names(airports);
+    for (int airport = 0; airport < airports; ++airport) std::snprintf(names[airport].text, sizeof(names[airport].text), "K%03d", airport);
+
+    RunwayCache runways;
+    double rebuildUs = 0.0, findNs = 0.0;
+    size_t found = 0;
+    for (int round = 0; round < ROUNDS; ++round) {
+        auto start = std::chrono::steady_clock::now();
+        for (int rebuild = 0; rebuild < REBUILDS; ++rebuild) {
+            runways.clear();
+            for (const char* end : ENDS)
+                for (const Name& name : names) runways.add(name.text, end);
+        }
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / REBUILDS;
+        if (round == 0 || us < rebuildUs) rebuildUs = us;
+
+        found = 0;
+        start = std::chrono::steady_clock::now();
+        for (int lookup = 0; lookup < LOOKUPS; ++lookup) found += runways.find(names[lookup % airports].text) != nullptr;
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / LOOKUPS;
+        if (round == 0 || ns < findNs) findNs = ns;
+    }
+
+    std::printf("%d airports, %d runway ends, best of %d rounds\n", airports, airports * 4, ROUNDS);
+    std::printf("rebuild %.1f us, find %.1f ns, %zu/%d lookups found\n", rebuildUs, findNs, found, LOOKUPS);
+    return runways.size() == static_cast<size_t>(airports) && found == static_cast<size_t>(LOOKUPS) ? 0 : 1;
+}
@@ -0,0 +1,135 @@
+// Hammers the Seqlock<PluginState> the EuroScope thread publishes and the presence thread reads:
+// one writer stores states as fast as it can while readers check that every field of each copy
+// comes from the same store. Reports the store and read rates, the retries and any torn copy.
+//
+//     rpc-seqlock-stress [seconds] [readers]
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "PluginState.h"
+#include "Seqlock.h"
+
+using namespace rpc;
+
+namespace {
+    // Every field is a function of the store number, so a copy mixing two stores shows
+    PluginState stateFor(uint64_t number)
+    {
+        PluginState state;
+        state.connectionType = static_cast<int32_t>(number % 5);
+        state.tier = static_cast<int32_t>(number % 3);
+        state.facility = static_cast<int32_t>(number % 7);
+        state.onlineTime = static_cast<int32_t>(number);
+        state.isOnFire = number & 1;
+        state.totalTracks = static_cast<uint32_t>(number * 3);
+        state.totalAircrafts = static_cast<uint32_t>(number * 5);
+        state.aircraftTracked = static_cast<uint32_t>(number * 7);
+        state.changeSequence = static_cast<uint32_t>(number ^ 0x5a5a5a5au);
+        state.changeCause = static_cast<int32_t>(number % static_cast<uint64_t>(ChangeCause::COUNT));
+        state.changedNs = number;
+
+        // The text fields are filled to the end, the last bytes change along with the first ones
+        char digits[24];
+        int length = std::snprintf(digits, sizeof(digits), "%llu", static_cast<unsigned long long>(number));
+        auto fill = [&](auto& field) {
+            size_t size = sizeof(field) - 1;
+            for (size_t i = 0; i < size; ++i) field[i] = digits[i % length];
+            field[size] = '\0';
+        };
+        fill(state.callsign);
+        fill(state.frequency);
+        fill(state.runways);
+        fill(state.idlingText);
+        fill(state.badge);
+        return state;
+    }
+
+    bool isConsistent(const PluginState& state)
+    {
+        PluginState expected = stateFor(state.changedNs);
+        return state.connectionType == expected.connectionType && state.tier == expected.tier
+            && state.facility == expected.facility && state.onlineTime == expected.onlineTime
+            && state.isOnFire == expected.isOnFire && state.totalTracks == expected.totalTracks
+            && state.totalAircrafts == expected.totalAircrafts && state.aircraftTracked == expected.aircraftTracked
+            && state.changeSequence == expected.changeSequence && state.changeCause == expected.changeCause
+            && std::memcmp(state.callsign, expected.callsign, sizeof(state.callsign)) == 0
+            && std::memcmp(state.frequency, expected.frequency, sizeof(state.frequency)) == 0
+            && std::memcmp(state.runways, expected.runways, sizeof(state.runways)) == 0
+            && std::memcmp(state.idlingText, expected.idlingText, sizeof(state.idlingText)) == 0
+            && std::memcmp(state.badge, expected.badge, sizeof(state.badge)) == 0;
+    }
+
+    struct alignas(CACHE_LINE_SIZE) ReaderResult {
+        uint64_t reads = 0;
+        uint64_t retries = 0;
+        uint64_t torn = 0;
+        uint64_t backwards = 0;
+    };
+}
+
+int main(int argc, char** argv)
+{
+    double seconds = argc > 1 ? std::atof(argv[1]) : 5.0;
+    int readerCount = argc > 2 ? std::atoi(argv[2]) : static_cast<int>(std::clamp(std::thread::hardware_concurrency(), 2u, 4u)) - 1;
+    if (seconds <= 0.0 || readerCount < 1) {
+        std::fprintf(stderr, "usage: %s [seconds] [readers]\n", argv[0]);
+        return 2;
+    }
+
+    Seqlock<PluginState> published;
+    published.store(stateFor(0));
+    std::atomic<bool> running{ true };
+    std::vector<ReaderResult> results(readerCount);
+    std::vector<std::thread> readers;
+    for (int reader = 0; reader < readerCount; ++reader) {
+        readers.emplace_back([&, reader] {
+            ReaderResult& result = results[reader];
+            uint64_t last = 0;
+            PluginState state;
+            while (running.load(std::memory_order_relaxed)) {
+                if (!published.tryLoad(state)) {
+                    ++result.retries;
+                    continue;
+                }
+                ++result.reads;
+                if (!isConsistent(state)) ++result.torn;
+                if (state.changedNs < last) ++result.backwards;
+                last = state.changedNs;
+            }
+        });
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+    uint64_t stores = 0;
+    while (true) {
+        // The state is built outside the write section, as the EuroScope thread does
+        for (int batch = 0; batch < 256; ++batch) {
+            PluginState state = stateFor(++stores);
+            published.store(state);
+        }
+        if (std::chrono::steady_clock::now() >= deadline) break;
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    running = false;
+    for (std::thread& reader : readers) reader.join();
+
+    ReaderResult total;
+    for (const ReaderResult& result : results) {
+        total.reads += result.reads;
+        total.retries += result.retries;
+        total.torn += result.torn;
+        total.backwards += result.backwards;
+    }
+    std::printf("%zu byte state, 1 writer, %d readers, %.2f s\n", sizeof(PluginState), readerCount, elapsed);
+    std::printf("%.0f stores/s, %.0f reads/s, %.1f%% of read attempts retried\n", stores / elapsed, total.reads / elapsed,
+        total.reads + total.retries ? 100.0 * total.retries / (total.reads + total.retries) : 0.0);
+    std::printf("%llu torn copies, %llu reads went backwards\n", static_cast<unsigned long long>(total.torn),
+        static_cast<unsigned long long>(total.backwards));
+    return total.torn == 0 && total.backwards == 0 && total.reads > 0 ? 0 : 1;
+}
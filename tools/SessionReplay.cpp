@@ -0,0 +1,546 @@
+// Replays a session recorded with ".rpc record" through the portable core of the plugin: handoff
+// tracking, sector forecast, target grid, controller registry, workload and presence rendering.
+// Time comes from the recording, so a long session replays in seconds and two builds can be
+// compared on identical input.
+//
+//     rpc-replay [--speed N] [--frames] EuroscopeRPC-1760000000.session
+//
+//     rpc-replay --feed [--as EDDF_TWR --at 50.03,8.56] vatsim-1200.json vatsim-1215.json ...
+//
+// --speed N paces the replay at N times real time, the default runs as fast as possible.
+// --frames prints every presence frame whose text changed.
+// --feed replays saved VATSIM data feed snapshots instead, in the order given, as the traffic
+// EuroScope would have shown. --as picks the controller that is us, --at where we sit since the
+// feed carries no controller positions.
+//
+// Not replayed: movement counters, comms and voice statistics, badges, METARs and runways, the
+// session tracks list, time under control and Discord's update limit. Frames therefore never
+// carry a badge, and every frame counts even where Discord's limit would hold one back.
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "AdaptiveInterval.h"
+#include "Callsign.h"
+#include "ControllerRegistry.h"
+#include "HandoffTracker.h"
+#include "PluginTuning.h"
+#include "Presence.h"
+#include "PresenceCadence.h"
+#include "SectorForecast.h"
+#include "SessionReader.h"
+#include "TargetGrid.h"
+#include "VatsimFeed.h"
+#include "WorkloadEstimator.h"
+
+using namespace rpc;
+using namespace rpc::session;
+
+namespace {
+    // Seconds between two snapshots of the feed when one has no update_timestamp
+    constexpr int64_t FEED_INTERVAL_MS = 15000;
+
+    enum Stage {
+        DECODE = 0,
+        PARSE,
+        HANDOFFS,
+        FORECAST,
+        TARGETS,
+        CONTROLLERS,
+        TICK,
+        RENDER,
+        STAGE_COUNT
+    };
+    constexpr const char* STAGE_NAMES[STAGE_COUNT] = { "decode", "parse", "handoffs", "forecast", "targets", "controllers", "tick", "render" };
+
+    struct StageTimer {
+        uint64_t nanoseconds[STAGE_COUNT] = {};
+        uint64_t calls[STAGE_COUNT] = {};
+
+        template <typename Function>
+        void time(Stage stage, Function&& function)
+        {
+            auto start = std::chrono::steady_clock::now();
+            function();
+            nanoseconds[stage] += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+            ++calls[stage];
+        }
+    };
+
+    // The plugin state machine without the SDK: what OnTimer and the callbacks do, fed from the log
+    class Replay
+    {
+    public:
+        Replay(int64_t startMs, bool printFrames) : startSeconds_(startMs / 1000), lastTick_(startMs / 1000), printFrames_(printFrames)
+        {
+            PluginState::copy(state_.idlingText, "Watching the skies");
+        }
+
+        void apply(const Event& event, StageTimer& timer)
+        {
+            int64_t now = event.timeMs / 1000;
+            while (lastTick_ < now) tick(++lastTick_, timer);
+
+            PackedCallsign callsign = packCallsign(event.callsign);
+            switch (event.type) {
+            case RecordType::RADAR_POSITION:
+                timer.time(TARGETS, [&] {
+                    targetGrid_.update(callsign, event.latitude / COORDINATE_SCALE, event.longitude / COORDINATE_SCALE, now);
+                    if (now - lastTargetExpiry_ >= TARGET_EXPIRY_INTERVAL) {
+                        lastTargetExpiry_ = now;
+                        targetGrid_.expire(now, TARGET_TIMEOUT);
+                    }
+                });
+                break;
+            case RecordType::FLIGHT_PLAN_DATA:
+                timer.time(FORECAST, [&] { sectorForecast_.update(callsign, event.entryMinutes, event.exitMinutes, now / 60); });
+                break;
+            case RecordType::CONTROLLER_ASSIGNED:
+                timer.time(HANDOFFS, [&] { controllerAssigned(callsign, event); });
+                break;
+            case RecordType::CONTROLLER_POSITION:
+                timer.time(CONTROLLERS, [&] { controllerPosition(callsign, event); });
+                break;
+            case RecordType::FLIGHT_PLAN_DISCONNECT:
+                timer.time(HANDOFFS, [&] {
+                    handoffTracker_.remove(callsign);
+                    sectorForecast_.remove(callsign);
+                    targetGrid_.remove(callsign);
+                    tracked_.erase(callsign);
+                });
+                break;
+            case RecordType::CONTROLLER_DISCONNECT:
+                timer.time(CONTROLLERS, [&] { controllerRegistry_.remove(callsign); });
+                break;
+            case RecordType::CONNECTION_TYPE:
+                if (event.code != state_.connectionType) transition_ = true;
+                if (event.code == State::IDLE) targetGrid_.reset();
+                state_.connectionType = event.code;
+                break;
+            default:
+                break;
+            }
+        }
+
+        void finish(int64_t endMs, StageTimer& timer)
+        {
+            while (lastTick_ < endMs / 1000) tick(++lastTick_, timer);
+        }
+
+        const PresenceFrame& getFrame() const { return frame_; }
+        uint64_t getFrames() const { return frames_; }
+        uint64_t getFrameChanges() const { return frameChanges_; }
+        const PluginState& getState() const { return state_; }
+        double getScore() const { return workload_.getScore(); }
+
+    private:
+        void controllerAssigned(PackedCallsign callsign, const Event& event)
+        {
+            bool trackingIsMe = event.flags & TRACKING_IS_ME;
+            if (uint32_t handoffs = handoffTracker_.update(callsign, trackingIsMe, event.flags & HANDOFF_PENDING, event.flags & HANDOFF_TARGET_IS_ME))
+                workload_.recordHandoff(handoffs);
+            if (trackingIsMe && (event.flags & IS_INSTRUCTION)) workload_.recordInstruction();
+
+            // The plugin polls GetTrackingControllerIsMe, the log only has its changes
+            if (trackingIsMe) {
+                if (tracked_.insert(callsign).second) transition_ = true;
+                if (everTracked_.insert(callsign).second) {
+                    ++state_.totalTracks;
+                    workload_.recordNewTrack();
+                }
+            }
+            else if (tracked_.erase(callsign)) transition_ = true;
+        }
+
+        void controllerPosition(PackedCallsign callsign, const Event& event)
+        {
+            ControllerRegistry::Controller record;
+            record.callsign = callsign;
+            record.facility = (event.flags & IS_CONTROLLER) ? event.facility : 0;
+            record.rating = event.rating;
+            record.frequencyKhz = event.frequencyKhz;
+            record.latitude = event.latitude / COORDINATE_SCALE;
+            record.longitude = event.longitude / COORDINATE_SCALE;
+            controllerRegistry_.update(record);
+
+            if (!(event.flags & IS_SELF)) return;
+            double range = event.range > 0 ? static_cast<double>(event.range) : NEARBY_ATC_RANGE;
+            controllerRegistry_.setReference(callsign, record.latitude, record.longitude, range);
+            if (event.range > 0) targetGrid_.setReference(record.latitude, record.longitude, range);
+
+            PluginState::copy(state_.callsign, event.callsign);
+            char frequency[16];
+            std::snprintf(frequency, sizeof(frequency), "%.3f", event.frequencyKhz / 1000.0);
+            PluginState::copy(state_.frequency, frequency);
+        }
+
+        // One simulated second: OnTimer's data refresh and the presence thread, each at its adaptive
+        // cadence, both cut short by a transition
+        void tick(int64_t now, StageTimer& timer)
+        {
+            bool woken = transition_;
+            transition_ = false;
+            if (now >= nextData_ || woken) {
+                timer.time(TICK, [&] {
+                    bool changed = tracked_.size() != state_.aircraftTracked || state_.connectionType != lastConnection_;
+                    int32_t tierBefore = state_.tier;
+                    lastConnection_ = state_.connectionType;
+                    state_.totalAircrafts = static_cast<uint32_t>(targetGrid_.size());
+                    state_.aircraftTracked = static_cast<uint32_t>(tracked_.size());
+                    int64_t online = now - startSeconds_;
+                    state_.tier = tierFor(online);
+                    state_.onlineTime = static_cast<int32_t>(online / 3600);
+                    workload_.setTracked(state_.aircraftTracked);
+                    changed |= workload_.update(now) || state_.tier != tierBefore;
+                    state_.isOnFire = workload_.isOnFire();
+                    nextData_ = now + dataInterval_.update(changed);
+                    woken |= changed;
+                });
+            }
+
+            if (!woken && (parked_ || now < nextRender_)) return;
+            timer.time(RENDER, [&] {
+                PresenceInput input;
+                input.state = state_;
+                if (state_.connectionType == State::CONTROLLING)
+                    input.inboundSoon = sectorForecast_.inboundWithin(FORECAST_MINUTES, now / 60);
+                input.aircraftInRange = targetGrid_.hasReference() ? targetGrid_.getInRangeCount() : state_.totalAircrafts;
+                HandoffTracker::Counters handoffs = handoffTracker_.getCounters();
+                input.handoffsIn = handoffs.inbound;
+                input.handoffsOut = handoffs.outbound;
+                input.nearbyControllers = controllerRegistry_.getNearbyCount();
+
+                PresenceFrame frame = formatPresence(input);
+                ++frames_;
+                bool settled = frame == frame_;
+                int64_t wait = presenceCadence_.next(settled, woken, state_.connectionType == State::IDLE, 1);
+                parked_ = wait == PRESENCE_PARKED;
+                nextRender_ = now + wait / 1000;
+                if (!settled) {
+                    ++frameChanges_;
+                    if (printFrames_) std::printf("%+8llds  %s | %s | %s | %s\n", static_cast<long long>(now - startSeconds_),
+                        frame.details.c_str(), frame.state.c_str(), frame.largeImageKey.c_str(), frame.smallImageText.c_str());
+                }
+                frame_ = std::move(frame);
+            });
+        }
+
+    private:
+        int64_t startSeconds_;
+        int64_t lastTick_;
+        bool printFrames_;
+
+        PluginState state_;
+        HandoffTracker handoffTracker_;
+        SectorForecast sectorForecast_;
+        ControllerRegistry controllerRegistry_;
+        TargetGrid targetGrid_;
+        int64_t lastTargetExpiry_ = 0;
+        bool transition_ = false;
+        int32_t lastConnection_ = State::IDLE;
+        AdaptiveInterval dataInterval_{ DATA_INTERVAL_MIN, DATA_INTERVAL_MAX, DATA_INTERVAL_INITIAL };
+        int64_t nextData_ = 0;
+        PresenceCadence presenceCadence_; // the plugin's own policy, one instance
+        int64_t nextRender_ = 0;
+        bool parked_ = false;
+        WorkloadEstimator workload_{ ONFIRE_THRESHOLD, ONFIRE_RELEASE_THRESHOLD };
+        std::unordered_set<PackedCallsign> tracked_;
+        std::unordered_set<PackedCallsign> everTracked_;
+
+        PresenceFrame frame_;
+        uint64_t frames_ = 0;
+        uint64_t frameChanges_ = 0;
+    };
+
+    // Whole file mapped read only
+    class MappedFile
+    {
+    public:
+        explicit MappedFile(const char* path)
+        {
+            int fd = open(path, O_RDONLY);
+            struct stat info;
+            if (fd < 0 || fstat(fd, &info) != 0) {
+                std::perror(path);
+                if (fd >= 0) close(fd);
+                return;
+            }
+            size_ = static_cast<size_t>(info.st_size);
+            void* mapping = size_ > 0 ? mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+            close(fd);
+            if (mapping == MAP_FAILED) {
+                std::fprintf(stderr, "%s: cannot map the file\n", path);
+                return;
+            }
+            madvise(mapping, size_, MADV_SEQUENTIAL);
+            data_ = static_cast<const uint8_t*>(mapping);
+        }
+        ~MappedFile()
+        {
+            if (data_) munmap(const_cast<uint8_t*>(data_), size_);
+        }
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        bool isOpen() const { return data_ != nullptr; }
+        const uint8_t* data() const { return data_; }
+        size_t size() const { return size_; }
+
+    private:
+        const uint8_t* data_ = nullptr;
+        size_t size_ = 0;
+    };
+
+    // Turns consecutive feed snapshots into the records the plugin would have captured. The feed
+    // has no controller positions and nothing is tracked, so the traffic comes through plus our own
+    // controller, placed where --at says; other controllers cannot be placed and are left out.
+    class FeedConverter
+    {
+    public:
+        FeedConverter(const char* self, const double* position) : self_(self ? self : "")
+        {
+            if (position) {
+                hasPosition_ = true;
+                latitude_ = position[0];
+                longitude_ = position[1];
+            }
+        }
+
+        template <typename Sink>
+        void convert(const VatsimFeed& feed, int64_t timeMs, Sink&& sink)
+        {
+            const VatsimFeed::Controller* self = nullptr;
+            for (const VatsimFeed::Controller& controller : feed.getControllers()) {
+                if (self_ == controller.callsign) self = &controller;
+            }
+            if (first_) {
+                first_ = false;
+                Event connection = event(RecordType::CONNECTION_TYPE, "", timeMs);
+                connection.code = self && self->facility > 0 ? State::CONTROLLING : State::OBSERVING;
+                sink(connection);
+            }
+
+            std::unordered_set<PackedCallsign> pilots, controllers;
+            for (const VatsimFeed::Pilot& pilot : feed.getPilots()) {
+                Event position = event(RecordType::RADAR_POSITION, pilot.callsign, timeMs);
+                position.latitude = toScaled(pilot.latitude);
+                position.longitude = toScaled(pilot.longitude);
+                position.altitude = pilot.altitude;
+                position.groundSpeed = pilot.groundSpeed;
+                pilots.insert(packCallsign(pilot.callsign));
+                sink(position);
+            }
+            if (self) {
+                Event position = event(RecordType::CONTROLLER_POSITION, self->callsign, timeMs);
+                position.flags = IS_SELF | (self->facility > 0 ? IS_CONTROLLER : 0);
+                position.facility = self->facility;
+                position.rating = self->rating;
+                position.frequencyKhz = self->frequencyKhz;
+                if (hasPosition_) {
+                    position.latitude = toScaled(latitude_);
+                    position.longitude = toScaled(longitude_);
+                    position.range = self->visualRange;
+                }
+                controllers.insert(packCallsign(self->callsign));
+                sink(position);
+            }
+
+            disconnect(lastPilots_, pilots, RecordType::FLIGHT_PLAN_DISCONNECT, timeMs, sink);
+            disconnect(lastControllers_, controllers, RecordType::CONTROLLER_DISCONNECT, timeMs, sink);
+            lastPilots_ = std::move(pilots);
+            lastControllers_ = std::move(controllers);
+        }
+
+    private:
+        static int32_t toScaled(double degrees) { return static_cast<int32_t>(std::lround(degrees * COORDINATE_SCALE)); }
+
+        static Event event(RecordType type, const char* callsign, int64_t timeMs)
+        {
+            Event result;
+            result.type = type;
+            result.timeMs = timeMs;
+            std::snprintf(result.callsign, sizeof(result.callsign), "%s", callsign);
+            return result;
+        }
+
+        template <typename Sink>
+        static void disconnect(const std::unordered_set<PackedCallsign>& before, const std::unordered_set<PackedCallsign>& now,
+            RecordType type, int64_t timeMs, Sink& sink)
+        {
+            for (PackedCallsign callsign : before) {
+                if (now.count(callsign)) continue;
+                sink(event(type, unpackCallsign(callsign).c_str(), timeMs));
+            }
+        }
+
+    private:
+        std::string self_;
+        bool hasPosition_ = false;
+        double latitude_ = 0.0;
+        double longitude_ = 0.0;
+        bool first_ = true;
+        std::unordered_set<PackedCallsign> lastPilots_;
+        std::unordered_set<PackedCallsign> lastControllers_;
+    };
+
+    void pace(double speed, std::chrono::steady_clock::time_point wallStart, int64_t elapsedMs)
+    {
+        if (speed <= 0.0) return;
+        std::this_thread::sleep_until(wallStart + std::chrono::duration<double, std::milli>(elapsedMs / speed));
+    }
+
+    void report(const Replay& replay, const StageTimer& timer, uint64_t events, double sessionSeconds, double wallSeconds)
+    {
+        std::printf("%llu events, %.0f s of session replayed in %.3f s (%.0fx real time)\n", static_cast<unsigned long long>(events),
+            sessionSeconds, wallSeconds, wallSeconds > 0 ? sessionSeconds / wallSeconds : 0.0);
+        std::printf("%.0f events/s, %llu presence frames, %llu changed\n", wallSeconds > 0 ? events / wallSeconds : 0.0,
+            static_cast<unsigned long long>(replay.getFrames()), static_cast<unsigned long long>(replay.getFrameChanges()));
+        std::printf("%.1f presence wakeups per minute (60 at a fixed one second tick)\n\n",
+            sessionSeconds > 0 ? replay.getFrames() * 60.0 / sessionSeconds : 0.0);
+
+        std::printf("%-12s %12s %12s %10s\n", "stage", "calls", "total ms", "ns/call");
+        for (int stage = 0; stage < STAGE_COUNT; ++stage) {
+            if (timer.calls[stage] == 0) continue;
+            std::printf("%-12s %12llu %12.3f %10.1f\n", STAGE_NAMES[stage], static_cast<unsigned long long>(timer.calls[stage]),
+                timer.nanoseconds[stage] / 1e6, static_cast<double>(timer.nanoseconds[stage]) / timer.calls[stage]);
+        }
+
+        const PresenceFrame& frame = replay.getFrame();
+        std::printf("\nfinal presence: %s | %s | %s | %s (score %.1f)\n", frame.details.c_str(), frame.state.c_str(),
+            frame.largeImageKey.c_str(), frame.smallImageText.c_str(), replay.getScore());
+    }
+
+    int replaySession(const char* path, double speed, bool printFrames)
+    {
+        MappedFile file(path);
+        if (!file.isOpen()) return 1;
+
+        SessionReader reader(file.data(), file.size());
+        if (!reader.isValid()) {
+            std::fprintf(stderr, "%s: not a session recording\n", path);
+            return 1;
+        }
+
+        Replay replay(reader.getStartMs(), printFrames);
+        StageTimer timer;
+        Event event;
+        uint64_t events = 0;
+        int64_t lastMs = reader.getStartMs();
+        auto wallStart = std::chrono::steady_clock::now();
+
+        while (true) {
+            bool decoded = false;
+            timer.time(DECODE, [&] { decoded = reader.next(event); });
+            if (!decoded) break;
+            ++events;
+            lastMs = event.timeMs;
+            pace(speed, wallStart, event.timeMs - reader.getStartMs());
+            replay.apply(event, timer);
+        }
+        replay.finish(lastMs, timer);
+
+        double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+        if (reader.isCorrupt()) std::fprintf(stderr, "%s: corrupt or truncated record at offset %zu, replayed up to there\n", path, reader.getOffset());
+
+        std::printf("%zu callsigns in the recording\n", reader.getCallsignCount());
+        report(replay, timer, events, (lastMs - reader.getStartMs()) / 1000.0, wallSeconds);
+        return 0;
+    }
+
+    int replayFeeds(const std::vector<const char*>& paths, const char* self, const double* position, double speed, bool printFrames)
+    {
+        VatsimFeed feed;
+        FeedConverter converter(self, position);
+        std::unique_ptr<Replay> replay;
+        StageTimer timer;
+        uint64_t events = 0;
+        uint64_t bytes = 0;
+        int64_t startMs = 0, lastMs = 0;
+        auto wallStart = std::chrono::steady_clock::now();
+
+        for (const char* path : paths) {
+            MappedFile file(path);
+            if (!file.isOpen()) return 1;
+
+            bool parsed = false;
+            uint64_t parsedBefore = timer.nanoseconds[PARSE];
+            timer.time(PARSE, [&] { parsed = feed.parse(std::string_view(reinterpret_cast<const char*>(file.data()), file.size())); });
+            if (!parsed) {
+                std::fprintf(stderr, "%s: %s\n", path, feed.getError().c_str());
+                return 1;
+            }
+            bytes += file.size();
+
+            int64_t timeMs = feed.getTimestampMs();
+            if (timeMs <= lastMs) timeMs = lastMs + (replay ? FEED_INTERVAL_MS : 0);
+            if (!replay) {
+                startMs = timeMs;
+                replay = std::make_unique<Replay>(startMs, printFrames);
+            }
+            lastMs = timeMs;
+            std::printf("%s: %zu pilots, %zu controllers, parsed in %.2f ms\n", path, feed.getPilots().size(), feed.getControllers().size(),
+                (timer.nanoseconds[PARSE] - parsedBefore) / 1e6);
+
+            pace(speed, wallStart, timeMs - startMs);
+            converter.convert(feed, timeMs, [&](const Event& event) {
+                ++events;
+                replay->apply(event, timer);
+            });
+        }
+        // Let the last snapshot stand for one feed interval
+        replay->finish(lastMs + FEED_INTERVAL_MS, timer);
+
+        double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+        double parseSeconds = timer.nanoseconds[PARSE] / 1e9;
+        std::printf("%zu feeds, %.1f MB parsed at %.0f MB/s\n", paths.size(), bytes / 1e6, parseSeconds > 0 ? bytes / 1e6 / parseSeconds : 0.0);
+        report(*replay, timer, events, (lastMs + FEED_INTERVAL_MS - startMs) / 1000.0, wallSeconds);
+        return 0;
+    }
+
+    int usage(const char* program)
+    {
+        std::fprintf(stderr, "usage: %s [--speed N] [--frames] <file.session>\n"
+                             "       %s --feed [--as CALLSIGN [--at LAT,LON]] [--speed N] [--frames] <snapshot.json>...\n"
+                             "Replays handoffs, sector forecast, target grid, controllers, workload and presence rendering.\n"
+                             "Not replayed: movements, comms and voice statistics, badges, METARs and runways, the session\n"
+                             "tracks list, time under control, Discord's update limit.\n", program, program);
+        return 2;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    double speed = 0.0;
+    bool printFrames = false;
+    bool feeds = false;
+    const char* self = nullptr;
+    double position[2];
+    bool hasPosition = false;
+    std::vector<const char*> paths;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--speed") == 0 && i + 1 < argc) speed = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--frames") == 0) printFrames = true;
+        else if (std::strcmp(argv[i], "--feed") == 0) feeds = true;
+        else if (std::strcmp(argv[i], "--as") == 0 && i + 1 < argc) self = argv[++i];
+        else if (std::strcmp(argv[i], "--at") == 0 && i + 1 < argc) {
+            if (std::sscanf(argv[++i], "%lf,%lf", &position[0], &position[1]) != 2) return usage(argv[0]);
+            hasPosition = true;
+        }
+        else if (argv[i][0] != '-') paths.push_back(argv[i]);
+        else return usage(argv[0]);
+    }
+    if (paths.empty() || (!feeds && (paths.size() > 1 || self)) || (hasPosition && !self)) return usage(argv[0]);
+
+    return feeds ? replayFeeds(paths, self, hasPosition ? position : nullptr, speed, printFrames) : replaySession(paths.front(), speed, printFrames);
+}
@@ -0,0 +1,66 @@
+// Times the tracking duration tag item the way OnGetTagItem serves it: the callback count, packing
+// the flight plan callsign, the TrackTimer probe and the copy into the item string. EuroScope asks
+// for every tag on every scope refresh, the budget is 50 ns per call.
+//
+//     rpc-tag-bench [targets]
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "FlightRecorder.h"
+#include "TrackTimer.h"
+
+using namespace rpc;
+
+namespace {
+    constexpr double BUDGET_NS = 50.0;
+    constexpr int REFRESHES = 1000;
+    constexpr int ROUNDS = 9; // the fastest counts, slower ones met another process on the core
+}
+
+int main(int argc, char** argv)
+{
+    int targets = argc > 1 ? std::atoi(argv[1]) : 400;
+    if (targets < 1) {
+        std::fprintf(stderr, "usage: %s [targets]\n", argv[0]);
+        return 2;
+    }
+
+    // Half of the targets tracked by me, started over the last two hours
+    std::vector<std::array<char, 16>> callsigns(targets);
+    TrackTimer trackTimer;
+    int64_t now = 1700000000;
+    for (int i = 0; i < targets; ++i) {
+        std::snprintf(callsigns[i].data(), callsigns[i].size(), "%s%d", i % 3 ? "AFR" : "EZY", 1000 + i * 7);
+        if (i % 2 == 0) trackTimer.start(packCallsign(callsigns[i].data()), now - i * 7200 / targets);
+    }
+    static FlightRecorder recorder; // the event ring is too large for the stack
+
+    // One scope refresh per second of tag time, so the minute changes and texts get rendered again
+    char itemString[16] = {};
+    size_t shown = 0;
+    double best = 0.0, worst = 0.0;
+    for (int round = 0; round < ROUNDS; ++round) {
+        auto start = std::chrono::steady_clock::now();
+        for (int refresh = 0; refresh < REFRESHES; ++refresh) {
+            int64_t tagNow = now + round * REFRESHES + refresh;
+            for (int i = 0; i < targets; ++i) {
+                recorder.countCallback(FlightRecorder::Callback::TAG_ITEM);
+                if (const char* text = trackTimer.text(packCallsign(callsigns[i].data()), tagNow)) {
+                    std::memcpy(itemString, text, TrackTimer::TEXT_SIZE);
+                    shown += itemString[0] != '\0';
+                }
+            }
+        }
+        double totalNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        double perCall = totalNs / (static_cast<double>(REFRESHES) * targets);
+        if (round == 0 || perCall < best) best = perCall;
+        if (perCall > worst) worst = perCall;
+    }
+
+    std::printf("%d targets, %d rounds of %d refreshes, %zu texts shown\n", targets, ROUNDS, REFRESHES, shown);
+    std::printf("%.1f ns per call (slowest round %.1f ns), budget %.0f ns\n", best, worst, BUDGET_NS);
+    return best <= BUDGET_NS ? 0 : 1;
+}